@@ -80,6 +80,7 @@
 #define KSEG2 0x40000000
 #define KUSEG 0x80000000
 #define RAMSTART 0x20000000
+#define RAMTOP_STACK_PAGES 12 /* frames below RAMTOP for the stacks of test() (with its support structs) and the delay daemon */
 #define BIOSDATAPAGE 0x0FFFF000
 #define PASSUPVECTOR 0x0FFFF900
 
@@ -123,8 +124,39 @@
 #define CPUTIMEGET 6
 #define CLOCKWAIT 7
 #define SUPPORTGET 8
+#define DOIO 30          /* issue a device command and wait for it, in one Nucleus entry */
+#define SETEDF 31        /* join (or leave) the EDF scheduling class */
+#define GETPROCSTAT 32   /* read a scheduling statistic of the Current Process */
+#define SETTICKETS 33    /* set the stride scheduling tickets of the Current Process */
+#define MAXNUCLEUSSYS SETTICKETS /* highest Nucleus syscall number, 9-29 belong to the Support Level */
+
+/* DOIO device argument: the (sub)device semaphore index, as devSemIdx */
+#define doioDev(intLineNo, devNo, termRead) (((intLineNo) - DISKINT + (termRead)) * DEVPERINT + (devNo))
 
 #define CLOCKINTERVAL 100000UL /* interval to V clock semaphore */
+#define QUANTUM 5000           /* initial round-robin time slice in us */
+#define QUANTUM_MIN 1000       /* slice of a process that keeps blocking early */
+#define QUANTUM_MAX 20000      /* slice of a process that keeps using its slice up */
+
+/* EDF scheduling class: density is budget / deadline in per-mille */
+#define EDF_DENSITY_ONE 1000            /* density of a process that needs a whole processor */
+#define EDF_DENSITY_MAX EDF_DENSITY_ONE /* admission bound on the total density, schedulable by global EDF */
+#define EDF_MIN_BUDGET 100              /* us, below this the dispatch itself eats the budget */
+#define EDF_MAX_PERIOD 1000000          /* us, keeps the density computation in range */
+
+/* Stride scheduling of the round-robin class: a process is charged its CPU time
+   divided by its tickets, and the ready process charged least runs next */
+#define STRIDE_DEFAULT_TICKETS 100 /* tickets of a new process */
+#define STRIDE_MAX_TICKETS 10000
+#define STRIDE_SCALE STRIDE_DEFAULT_TICKETS /* pass is in us for STRIDE_DEFAULT_TICKETS */
+
+/* GETPROCSTAT statistics */
+#define PSTAT_DLMISSES 0 /* EDF deadline misses */
+#define PSTAT_CPUTIME 1  /* CPU time used, as SYS6 */
+#define PSTAT_SWITCHES 2 /* times the process was dispatched */
+#define PSTAT_QUANTUM 3  /* its current time slice */
+#define PSTAT_ASID 4     /* its ASID, 0 without a support structure */
+#define PSTAT_FLASHBLOCKS 5 /* blocks of the U-proc's flash device, answered by the Support Level (SYS25) only */
 #define SYSCAUSE (0x8 << 2)
 
 /**********************************************************************************************
@@ -159,13 +191,37 @@
 /* Support level data structures related constants */
 #define VPN_SHIFT 12
 #define VPN_MASK 0x000FFFFF
-#define SWAP_POOL_SIZE 32
-#define SWAP_POOL_START 0x20020000 + BLOCKSIZE*16
-#define PAGE_TABLE_SIZE 32
+#define UPROC_IMAGE_PAGES 32 /* pages of a U-proc image staged from its flash device */
+#define PGTBL_LEAF_SIZE 32   /* pages mapped by one second-level page table */
+#define LEAF_SHIFT 5         /* log2(PGTBL_LEAF_SIZE) */
+#define PGDIR_SIZE 32        /* second-level page tables a U-proc may own */
+#define LEAF_POOL_SIZE 64    /* second-level page tables shared by all U-procs */
+#define SWAP_FIRST_SLOT (UPROC_IMAGE_PAGES * MAXUPROC) /* swap disk sectors below hold the staged U-proc images */
+#define SWAP_MAX_SLOTS 8192  /* swap slots tracked by the bitmap, over all swap devices */
+#define SWAP_DISK_MASK 0x01  /* disks holding swap, one bit per device; must have RESERVED_DISK_NO; closed to DISK_PUT/DISK_GET */
+#define SWAP_FLASH_MASK 0x00 /* flash devices holding swap from block SWAP_FLASH_FIRST on */
+#define UPROC_FLASH_BLOCKS 32 /* blocks past its image a U-proc may read and write on its flash device */
+#define SWAP_FLASH_FIRST (UPROC_IMAGE_PAGES + UPROC_FLASH_BLOCKS) /* past the U-proc image and the blocks left to it */
+#define SWAP_MAX_DEVS (2 * DEVPERINT)
+#define ZSWAP_PAGES 64       /* RAM pages of the compressed swap tier, from zswapStart */
+#define ZSWAP_CHUNK 64       /* bytes, allocation unit of the compressed swap tier */
+#define ZSWAP_CHUNKS (ZSWAP_PAGES * PAGESIZE / ZSWAP_CHUNK)
+#define ZSWAP_MAX_WORDS (PAGESIZE / WORDLEN / 2) /* pages compressing to more go to the swap devices */
+#define ZSWAP_SLOT 0x40000000 /* swap slot flag: the page is in the compressed tier, from this chunk */
+#define isZswapSlot(slot) ((slot) != NO_SLOT && ((slot) & ZSWAP_SLOT) != 0)
+#define SHARER_POOL_SIZE 64  /* mappings of shared frames besides their first one */
+#define SWAP_CLUSTER 4       /* victims paged out with one seek */
+#define LOAD_WINDOW 100000   /* us over which load control measures the fault rate, one pseudo-clock tick */
+#define LOAD_HIGH_FAULTS 50  /* faults per window with no free frame: thrashing, a U-proc is suspended */
+#define LOAD_LOW_FAULTS 10   /* faults per window up to which a suspended U-proc is let back in */
+#define LOAD_IDLE 0          /* load control state of an ASID: no U-proc has faulted under it yet */
+#define LOAD_ACTIVE 1        /* running */
+#define LOAD_SUSPENDED 2     /* held at its next page fault, its frames evicted first */
+#define NO_SLOT -1           /* page never paged out: zero filled on first use */
 #define ASID_SHIFT 6
+#define ASID_MASK 0x3F
 #define UPROC_NUM 1
 #define UPROC_STACK_AREA 0xBFFFF000
-#define LAST_USER_PAGE 0x8001E000
 #define TLB_STACK_AREA 499
 #define GEN_EXC_STACK_AREA 499
 
@@ -183,6 +239,7 @@
 #define UPROCSTACK 0xC0000000
 #define STARTVPN 0x80000
 #define UPROC_STACK_VPN 0xBFFFF
+#define NO_REGION -1
 
 /* READ/WRITE constants */
 #define NEW_LINE 10
@@ -229,15 +286,18 @@
    terminal write higher priority than terminal read*/
 #define devSemIdx(intLineNo, devNo, termRead) (intLineNo - 3) * 8 + termRead * 8 + devNo;
 
+/* pcb run states */
+#define PROC_RUNNING 0 /* Current Process of a processor */
+#define PROC_READY 1   /* on a ready queue */
+#define PROC_BLOCKED 2 /* on the queue of a semaphore in the ASL */
+#define PROC_NEW 3     /* allocated, on no queue yet */
+
 /* Maximum number of semaphore and pcb that can be allocated*/
 #define MAXPROC 20
 #define MAXSEM MAXPROC
 
 #define BLOCKSIZE   PAGESIZE
 
-#define DISK_DMA_BUFFER_BASE_ADDR   0x20020000
-#define FLASK_DMA_BUFFER_BASE_ADDR  0x20020000 + BLOCKSIZE*8
-
 #define READBLK_DSK     3
 #define WRITEBLK_DSK    4
 #define SEEKCYL         2
@@ -253,4 +313,75 @@
 
 #define RESERVED_DISK_NO 0
 
+/**********************************************************************************************
+ * Support level SYSCALL related constants
+ */
+#define MAXUPROC 8 /* one U-proc per flash device */
+
+#define SENDMSG 21 /* synchronous send of a word and, optionally, a page */
+#define RECVMSG 22 /* blocking receive of a word and, optionally, a page */
+#define GETLATENCY 23 /* copy one latency histogram of the caller's ASID */
+#define SETREALTIME 24 /* join the EDF class: period, budget, deadline in us */
+#define GETSCHEDSTAT 25 /* read a scheduling statistic (PSTAT_*) of the caller */
+#define SETSHARE 26 /* set the caller's stride scheduling tickets */
+
+/* Latency histograms: log2 buckets of microseconds, bucket b counts samples in [2^(b-1), 2^b) */
+#define HIST_BUCKETS 16
+#define HIST_REFILL 0  /* TLB-Refill service time */
+#define HIST_PGFAULT 1 /* page fault service time */
+#define HIST_IOWAIT 2  /* SYS5 block time, one histogram per device class from here */
+#define HIST_KINDS (HIST_IOWAIT + DEVINTNUM)
+
+/* Event trace ring buffer, drained to a printer with TRACEDUMP */
+#define TRACEDUMP 27       /* print the events traced since the last dump */
+#define TRACE_ENTRIES 256  /* ring buffer size, a power of two */
+#define TRACE_SWITCH 0     /* dispatch: pcb (0 when the processor goes idle), time slice */
+#define TRACE_SYSCALL 1    /* syscall: number, a1, a2 */
+#define TRACE_INTERRUPT 2  /* interrupt entry: pending lines */
+#define TRACE_PGFAULT 3    /* page fault: VPN, TLB cause */
+#define TRACE_EVICT 4      /* page out: frame, VPN, under the victim's ASID */
+#define TRACE_IOSTART 5    /* device command (DOIO): device semaphore index, command, data0 */
+#define TRACE_IODONE 6     /* device interrupt: device semaphore index, status */
+
+/* Sampling profiler: PC histograms per ASID of user mode code, index 0 for kernel mode */
+#define PROFILE 28          /* a1: PROF_START (a2: sample period in us, 0 for PLT expiries only), PROF_STOP, PROF_DUMP */
+#define PROF_START 0
+#define PROF_STOP 1
+#define PROF_DUMP 2
+#define PROF_BUCKETS 1024   /* buckets per histogram */
+#define PROF_SHIFT 6        /* 64 bytes of code per bucket */
+#define PROF_MIN_PERIOD 100 /* us, shorter periods would mostly sample the handler */
+
+/* Copy-on-write cloning of the calling U-proc */
+#define FORK 29    /* returns the child's ASID to the parent, 0 to the child, -1 if no ASID or page table is left */
+#define FORK_MAX 4 /* forked U-procs alive at once, each with a preallocated support struct */
+
+/**********************************************************************************************
+ * Multiprocessor related constants
+ */
+#ifndef NCPU
+#define NCPU 1 /* processors started by the Nucleus, set with -DNCPU=n to match the machine configuration, the same for every object of a kernel */
+#endif
+
+#define PASSUPVECTOR_SIZE 0x10   /* pass up vectors of the processors follow each other from PASSUPVECTOR */
+
+#define IRT_START 0x10000300     /* Interrupt Routing Table, one word per interrupt source */
+#define IRT_NUM_ENTRY 48
+#define IRT_RP_BIT_ON 0x10000000 /* dynamic routing: lowest priority processor among the destinations */
+#define CPUCTL_INBOX 0x10000400  /* IPI inbox of the accessing processor, written to acknowledge */
+#define CPUCTL_OUTBOX 0x10000404 /* IPI outbox of the accessing processor */
+#define CPUCTL_TPR 0x10000408    /* Task Priority Register of the accessing processor */
+#define IPI_RECIP_SHIFT 8        /* recipient set position in an outbox word */
+#define IPI_WAKEUP 1             /* IPI message: a process became ready */
+#define IPI_TLBFLUSH 2           /* IPI message: clear the TLB and acknowledge */
+#define IDLE_PRIORITY 0          /* TPR of a processor waiting for work, preferred by dynamic routing */
+#define BUSY_PRIORITY 1          /* TPR of a processor running a process */
+
+/* Saved exception state of a processor in the BIOS Data Page */
+#define GET_EXCEPTION_STATE_PTR(cpuId) ((state_PTR)(BIOSDATAPAGE + (cpuId) * sizeof(state_t)))
+#define EXCSTATE GET_EXCEPTION_STATE_PTR(getPRID())
+
+/* TLB Index register: P bit is set when a TLBP finds no matching entry */
+#define INDEXPBIT 0x80000000
+
 #endif
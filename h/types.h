@@ -77,17 +77,74 @@ typedef struct pte_t {
 	unsigned int EntryLo; /* PFN (Physical Frame Number) and Valid/Dirty bits */
 } pte_t;
 
+/* Second-level page table: maps the PGTBL_LEAF_SIZE pages of one aligned range of kuseg */
+typedef struct pgTblLeaf_t {
+	struct pgTblLeaf_t *l_next;      /* next free leaf */
+	int l_region;                    /* VPN >> LEAF_SHIFT of the mapped range, NO_REGION if free */
+	int l_slot[PGTBL_LEAF_SIZE];     /* swap disk sector holding each page, NO_SLOT if none */
+	pte_t l_pte[PGTBL_LEAF_SIZE];
+} pgTblLeaf_t;
+
 typedef struct swapPoolFrame_t {
 	int ASID;                    /* The ASID of the U-proc whose page is occupying the frame*/
 	int VPN;                    /* The logical page number (VPN) of the occupying page.*/
 	pte_t *matchingPgTableEntry; /* A pointer to the matching Page Table entry in the Page Table belonging to the owner process. (i.e. ASID)*/
+	int *slotRef;                /* swap slot entry of the occupying page in its owner's page table */
+	int pinned;                  /* TRUE while the frame is being handed over by SENDMSG; never picked as a victim */
+	int transit;                 /* TRUE while its page is read or written; never picked as a victim */
+	int imageSect;               /* image sector the frame holds unmodified, mapped read-only; NO_SLOT if written */
+	struct sharer_t *sharers;    /* other mappings of the frame, by U-procs with the same image page or forked */
 } swapPoolFrame_t;
 
+typedef struct sharer_t {
+	struct sharer_t *s_next;
+	int s_asid;
+	int s_vpn;
+	pte_t *s_pte;                /* its page table entry */
+	int *s_slotRef;              /* its swap slot entry */
+} sharer_t;
+
+typedef struct swapDev_t {
+	int sd_line;                 /* DISKINT or FLASHINT */
+	int sd_devNo;
+	int sd_first;                /* sector or block of its first swap slot */
+	int sd_base;                 /* swap slot number of its first swap slot */
+	int sd_slots;                /* swap slots on the device */
+	int sd_cursor;               /* where the next search for free slots starts, from sd_base */
+	int sd_heads, sd_sects;      /* disk geometry */
+	int sd_outstanding;          /* page-ins and page-outs queued or in progress */
+} swapDev_t;
+
+typedef struct zswapStat_t {
+	unsigned int z_stored;       /* pages put in the compressed swap tier */
+	unsigned int z_words;        /* words they took there, compressed */
+	unsigned int z_hits;         /* faults served from the compressed swap tier */
+	unsigned int z_reads;        /* faults served from the swap devices */
+} zswapStat_t;
+
+typedef struct loadStat_t {
+	unsigned int l_suspends;     /* times suspended by load control */
+	cpu_t l_heldTime;            /* us spent held off the ready queue */
+} loadStat_t;
+
+/* Mailbox of a U-proc for SENDMSG/RECVMSG, one per ASID */
+typedef struct msgBox_t {
+	int mb_slotMutex;   /* one sender at a time owns the slot */
+	int mb_recvSem;     /* V'ed by the sender once the slot is filled */
+	int mb_doneSem;     /* V'ed by the receiver once the message is taken */
+	int mb_senderASID;  /* ASID of the sender occupying the slot */
+	int mb_word;        /* the register-sized message */
+	int mb_frame;       /* pinned swap pool frame carrying the page, -1 if none */
+	int mb_openMutex;   /* posting a message and closing the box exclude each other */
+	int mb_closed;      /* TRUE while no U-proc with this ASID can receive */
+} msgBox_t;
+
 /**********************************************************************************************
  * pcb related structs
  */
 
 #define STATEREGNUM 31
+#define STATEWORDS (STATEREGNUM + 4) /* words in a state_t: 35, a multiple of 5 */
 typedef struct state_t {
 	unsigned int s_entryHI;
 	unsigned int s_cause;
@@ -109,13 +166,31 @@ typedef struct support_t {
 	int sup_asid;                   /* Process Id (asid) */
 	state_t sup_exceptState[2];     /* stored excpt states */
 	context_t sup_exceptContext[2]; /* pass up contexts */
-	pte_t sup_privatePgTbl[32];     /* A Pandos Page Table will be an array of 32 Page Table entries _ pg 43 pandos */
+	pgTblLeaf_t *sup_pgDir[PGDIR_SIZE]; /* first-level page table, hashed by range; leaves are allocated on demand */
+	int sup_leafCount;              /* slots of sup_pgDir in use, at most PGDIR_SIZE - 1 */
 	int sup_stackTlb[500];          /* 2Kb area for the stack area for the process TLB exception handler*/
 	int sup_stackGen[500];          /* 2Kb area for the stack area for the process's Support Level general exception handler*/
 
 	int delaySem; /* delay facility for phase 5*/
 } support_t;
 
+/* Latency histogram */
+typedef struct latHist_t {
+	unsigned int h_count[HIST_BUCKETS]; /* samples per log2 bucket */
+	unsigned int h_samples;             /* total number of samples */
+	unsigned int h_total;               /* sum of the samples, in microseconds */
+} latHist_t;
+
+/* Event of the trace ring buffer */
+typedef struct traceEvent_t {
+	unsigned int e_seq;    /* sequence number + 1, written last: 0 or stale while the event is being written */
+	cpu_t e_tod;           /* TOD of the event */
+	int e_kind;            /* TRACE_* */
+	int e_cpu;             /* processor it happened on */
+	int e_asid;            /* ASID of the process concerned, 0 if none */
+	unsigned int e_arg[3]; /* depend on the kind */
+} traceEvent_t;
+
 /********************************************************************************************
  * phase 5 structs
  */
@@ -140,10 +215,39 @@ typedef struct pcb_t {
 	cpu_t p_time;         /* cpu time used by proc */
 	int *p_semAdd;        /* ptr to semaphore on */
 	                      /* which proc is blocked */
+	cpu_t p_ioStart;      /* TOD when it last blocked on SYS5 */
+	int p_state;          /* PROC_NEW, PROC_RUNNING, PROC_READY or PROC_BLOCKED */
+	struct pcb_t **p_queue; /* tail ptr of the queue holding it, NULL if none */
+	                      /* EDF scheduling class, p_period 0 for round-robin */
+	cpu_t p_period;       /* release period in us */
+	cpu_t p_budget;       /* CPU time granted per period */
+	cpu_t p_relDeadline;  /* deadline relative to the release */
+	cpu_t p_release;      /* TOD of the next release */
+	cpu_t p_deadline;     /* absolute deadline of the current job */
+	cpu_t p_budgetLeft;   /* budget left to the current job */
+	int p_jobOpen;        /* TRUE until the job blocks, uses its budget up or misses */
+	int p_misses;         /* deadline misses */
+	                      /* stride scheduling, round-robin class */
+	int p_tickets;        /* share of the processor */
+	unsigned int p_pass;  /* CPU time charged per ticket, scaled by STRIDE_SCALE */
+	int p_passRem;        /* remainder of the last charge */
+	cpu_t p_quantum;      /* round-robin time slice, adapted to its behaviour */
+	int p_switches;       /* times it was dispatched */
 	                      /* support layer information */
 	support_t *p_supportStruct;
 } pcb_t, *pcb_PTR;
 
+/* per-processor Nucleus state */
+typedef struct cpuState_t {
+	pcb_PTR c_currentP;        /* process running on this processor */
+	pgTblLeaf_t **c_pgDir;     /* its first-level page table, for the TLB-Refill handler */
+	pcb_PTR c_readyQ;          /* tail ptr to this processor's ready queue */
+	cpu_t c_acctStart;         /* TOD of the last CPU time charge */
+	int c_idle;                /* TRUE while waiting for an interrupt */
+	cpu_t c_sliceLeft;         /* time slice left after the current profiling period */
+	int c_fullSlice;           /* TRUE if the slice loaded is the whole quantum of the process */
+} cpuState_t;
+
 /********************************************************************************************
  * phase 1 structs
  */
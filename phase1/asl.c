@@ -9,7 +9,8 @@
  *      This module includes public functions to support initializing ASL,
  *      insert into queue of a sema4 in ASL using insertBlockec(),
  *      removing from head queue of a sema4 in ASL using removeBlocked(),
- *      removing from anywhere in queue of a a sema4 in ASL outBlocked(),
+ *      removing from anywhere in queue of a a sema4 in ASL outBlocked(), which goes
+ *      straight to the queue recorded in the pcb and walks the ASL only to free an emptied sema4,
  *      accessing head of a queue of a sema4 in ASL headBlocked().
  *      Some helper functions (not accessible publicly) are also implemented in this file.
  *      Modified by Phuong and Oghap on Feb 2025
@@ -147,6 +148,7 @@ int insertBlocked(int *semAdd, pcb_PTR p) {
 	/*insert into the queue of the found sema4 using insertProcQ from pcb module*/
 	insertProcQ(&(predecessor->s_next->s_procQ), p);
 	p->p_semAdd = semAdd;
+	p->p_state = PROC_BLOCKED;
 	return FALSE;
 }
 
@@ -199,14 +201,21 @@ pcb_PTR removeBlocked(int *semAdd) {
  */
 pcb_PTR outBlocked(pcb_PTR p) {
 	int *semAdd = p->p_semAdd;
-	/*look for the predecessor*/
-	semd_t *predecessor = traverseASL(semAdd);
-	/*special case where the given sema4 descriptor does not exist in ASL or its queue is empty*/
-	if(predecessor->s_next->s_semAdd != semAdd || emptyProcQ(predecessor->s_next->s_procQ)) {
+	pcb_PTR *tp = p->p_queue;
+	/*special case where the pcb is not queued on a sema4*/
+	if(p->p_state != PROC_BLOCKED || tp == NULL) {
 		return NULL;
 	}
-	/*remove pcb from the queue of the found sema4 using outProcQ() from pcb module*/
-	return outProcQ(&(predecessor->s_next->s_procQ), p);
+	/*remove pcb straight from the queue of its sema4 using outProcQ() from pcb module*/
+	outProcQ(tp, p);
+	/*removing sema4 from ASL if no longer active, the only case needing the predecessor*/
+	if(emptyProcQ(*tp)) {
+		semd_t *predecessor = traverseASL(semAdd);
+		semd_t *toBeFreeSem = predecessor->s_next;
+		predecessor->s_next = toBeFreeSem->s_next;
+		freeSemd(toBeFreeSem);
+	}
+	return p;
 }
 /**********************************************************
  *  Accessing head of a queue of a sema4 in ASL
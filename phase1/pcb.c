@@ -5,6 +5,9 @@
  *  with p_prev and p_next fields. And the process queues are pointed by
  *  a tail pointer instead of a head pointer.
  *
+ *  Every queued pcb records the address of its queue's tail pointer (p_queue),
+ *  so outProcQ() checks membership and unlinks in constant time.
+ *
  *  The pcbs are also organized into trees of pcbs, called process trees.
  *  The p_prnt, p_child, and p_sib pointers are used for this purpose.
  *  A parent pcb contains a pointer (p_child) to a single, doubly linearly linked
@@ -75,6 +78,17 @@ pcb_PTR allocPcb() {
 	}
 	allocatedPcb->p_time = 0;
 	allocatedPcb->p_semAdd = NULL;
+	allocatedPcb->p_ioStart = 0;
+	allocatedPcb->p_state = PROC_NEW;
+	allocatedPcb->p_queue = NULL;
+	allocatedPcb->p_period = 0;
+	allocatedPcb->p_jobOpen = FALSE;
+	allocatedPcb->p_misses = 0;
+	allocatedPcb->p_tickets = STRIDE_DEFAULT_TICKETS;
+	allocatedPcb->p_pass = 0;
+	allocatedPcb->p_passRem = 0;
+	allocatedPcb->p_quantum = QUANTUM;
+	allocatedPcb->p_switches = 0;
 	allocatedPcb->p_supportStruct = NULL;
 
 	return allocatedPcb;
@@ -150,6 +164,8 @@ int emptyProcQ(pcb_PTR tp) {
  *
  */
 void insertProcQ(pcb_PTR *tp, pcb_PTR p) {
+	p->p_queue = tp;
+
 	/* Special case - if pq is empty, make p the tail */
 	if(emptyProcQ(*tp)) {
 		(*tp) = p;
@@ -196,6 +212,7 @@ pcb_PTR removeProcQ(pcb_PTR *tp) {
 	if(rm == (*tp)) {
 		(*tp) = NULL;
 	}
+	rm->p_queue = NULL;
 
 	return rm;
 }
@@ -205,7 +222,8 @@ pcb_PTR removeProcQ(pcb_PTR *tp) {
  * pointer is pointed to by tp. Update the process queue’s tail pointer if
  * necessary. If the desired entry is not in the indicated queue (an error
  * condition), return NULL; otherwise, return p. Note that p can point
- * to any element of the process queue
+ * to any element of the process queue; p_queue tells whether p is in
+ * it, so no traversal is needed.
  *
  *  Parameters:
  *       pcb_PTR *tp   - the address of the tail pointer of pq
@@ -220,14 +238,8 @@ pcb_PTR outProcQ(pcb_PTR *tp, pcb_PTR p) {
 		return NULL;
 	}
 
-	/* find the element p */
-	pcb_PTR traverse = *tp;
-	while((traverse != p) && (traverse->p_next != (*tp))) {
-		traverse = traverse->p_next;
-	}
-
 	/* Special Case - when p is not in the pq */
-	if(traverse != p) {
+	if(p->p_queue != tp) {
 		return NULL;
 	}
 
@@ -249,6 +261,7 @@ pcb_PTR outProcQ(pcb_PTR *tp, pcb_PTR p) {
 	/* setting removed pcb values to NULL */
 	p->p_prev = NULL;
 	p->p_next = NULL;
+	p->p_queue = NULL;
 
 	return p;
 }
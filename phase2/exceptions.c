@@ -11,8 +11,10 @@
  *  - exception_handler(): Determines the type of exception and
  *    delegates processing to specialized handlers.
  *  - interrupt_exception_handler(): Handles external device interrupts
- *  - SYSCALL_handler(): Processes system calls (SYS1–SYS8), allowing user processes to
+ *  - SYSCALL_handler(): Processes system calls (SYS1–SYS8 and SYS30–SYS33), allowing user processes to
  *    request services such as process management, I/O operations, and clock waiting.
+ *    Calls are dispatched through syscallTable; a call that does not block returns
+ *    straight from the BIOS Data Page, and only a blocking one saves the state in the pcb.
  *  - pass_up_or_die(): Handles program traps and TLB exceptions. If the process
  *    has a support structure, the exception is passed up to the user-level handler;
  *    otherwise, the process and its children are terminated.
@@ -20,6 +22,9 @@
  *  The exception handling system integrates with the process scheduler to manage
  *  blocked.
  *
+ *  exception_handler() takes the Nucleus lock; every path out of the Nucleus
+ *  (LDST, LDCXT, or the scheduler) releases it.
+ *
  *      Modified by Phuong and Oghap on Feb 2025
  */
 
@@ -33,6 +38,8 @@
 #include "scheduler.h"
 #include "interrupts.h"
 #include "initial.h"
+#include "histogram.h"
+#include "trace.h"
 
 #include "exceptions.h"
 
@@ -61,30 +68,6 @@ HIDDEN void helper_PASSEREN(int *sema4) {
 	return;
 }
 
-/**********************************************************
- *  deep_copy_state_t()
- *
- *  Deep copies the contents of a source processor state into a
- *  destination processor state.
- *
- *  Parameters:
- *         state_PTR dest - Pointer to the destination state
- *         state_PTR src  - Pointer to the source state
- *
- *  Returns:
- *
- **********************************************************/
-HIDDEN void deep_copy_state_t(state_PTR dest, state_PTR src) {
-	dest->s_cause = src->s_cause;
-	dest->s_entryHI = src->s_entryHI;
-	dest->s_pc = src->s_pc;
-	int i;
-	for(i = 0; i < STATEREGNUM; i++) {
-		dest->s_reg[i] = src->s_reg[i];
-	}
-	dest->s_status = src->s_status;
-}
-
 /**********************************************************
  *  helper_blocking_syscall_handler()
  *
@@ -103,11 +86,14 @@ HIDDEN void helper_blocking_syscall_handler() {
 	/*
 	This function handle the steps after a blocking handler including:
 	*/
-	((state_PTR)BIOSDATAPAGE)->s_pc += WORDLEN;
+	EXCSTATE->s_pc += WORDLEN;
 	/* save processor state copy into current process pcb*/
-	deep_copy_state_t(&(currentP->p_s), BIOSDATAPAGE);
-	/*update the cpu time for the current process*/
-	currentP->p_time += (5000 - getTIMER());
+	deep_copy_state_t(&(currentP->p_s), EXCSTATE);
+	/*update the cpu time for the current process, servicing its syscall included*/
+	acct_charge_process();
+	/* blocking ends the current EDF job, and shortens the quantum if it came early */
+	currentP->p_jobOpen = FALSE;
+	quantum_adapt(currentP, FALSE);
 	/*process was already added to ASL in the syscall =>already blocked*/
 	scheduler();
 }
@@ -127,11 +113,12 @@ HIDDEN void helper_blocking_syscall_handler() {
  **********************************************************/
 HIDDEN void helper_non_blocking_syscall_handler() {
 	/*increment PC by 4*/
-	((state_PTR)BIOSDATAPAGE)->s_pc += WORDLEN;
-	/* update the cpu_time*/
-	currentP->p_time += (5000 - getTIMER());
+	EXCSTATE->s_pc += WORDLEN;
+	/* update the cpu_time, servicing its syscall included*/
+	acct_charge_process();
 	/*save processor state into the "well known" location for return*/
-	LDST((state_PTR)BIOSDATAPAGE);
+	kernel_unlock();
+	LDST(EXCSTATE);
 }
 
 /**********************************************************
@@ -150,19 +137,68 @@ HIDDEN int check_KU_mode_bit() {
 	Examines the Status register in the saved exception state.
 	In particular, examine the previous version of the KU bit (KUp)
 	*/
-	int KUp = ((state_PTR)BIOSDATAPAGE)->s_status & 0x00000008;
+	int KUp = EXCSTATE->s_status & 0x00000008;
 	if(KUp == 0) {
 		return 0;
 	}
 	return 1;
 }
 
+/**********************************************************
+ *  helper_release_process()
+ *
+ *  Takes a process out of wherever its run state says it is
+ *  (a semaphore queue, a ready queue, or another processor),
+ *  then frees its pcb.
+ *
+ *  Parameters:
+ *         pcb_PTR toBeTerminate - Pointer to the process to release
+ *
+ *  Returns:
+ *
+ **********************************************************/
+HIDDEN void helper_release_process(pcb_PTR toBeTerminate) {
+	int *semAdd = toBeTerminate->p_semAdd;
+
+	switch(toBeTerminate->p_state) {
+		case PROC_BLOCKED:
+			outBlocked(toBeTerminate);
+			/*if terminated process is not blocked on our device semaphore */
+			if(semAdd < &device_sem[0] || semAdd > &device_sem[DEVINTNUM * DEVPERINT + DEVPERINT + 1 - 1]) {
+				if((*semAdd) < 0) {
+					(*semAdd)++;
+				}
+			} else {
+				softBlock_count--;
+			}
+			break;
+		case PROC_READY:
+			out_ready(toBeTerminate);
+			break;
+		case PROC_RUNNING:
+			/* stop it if it runs on another processor */
+			smp_stop_remote(toBeTerminate);
+			break;
+		default:
+			break;
+	}
+
+	/* give its EDF reservation back */
+	edf_leave(toBeTerminate);
+
+	/* free the pcb and decrease process count*/
+	freePcb(toBeTerminate);
+	process_count--;
+}
+
 /**********************************************************
  *  helper_terminate_process()
  *
- *  Recursively terminates a process and all its children processes.
- *  Removes the process from the process queue, device semaphores,
- *  and releases.
+ *  Terminates a process and all its progeny with an
+ *  iterative post-order walk of the process tree: each
+ *  process is released once its children are, so the time
+ *  is proportional to the size of the tree and the Nucleus
+ *  stack does not grow with its depth.
  *
  *  Parameters:
  *         pcb_PTR toBeTerminate - Pointer to the process to terminate
@@ -171,35 +207,24 @@ HIDDEN int check_KU_mode_bit() {
  *
  **********************************************************/
 HIDDEN void helper_terminate_process(pcb_PTR toBeTerminate) {
-	pcb_PTR childToBeTerminate = removeChild(toBeTerminate);
-	/* recursively, all progeny of this process are terminated as well. */
-	while(childToBeTerminate != NULL) {
-		helper_terminate_process(childToBeTerminate);
-		childToBeTerminate = removeChild(toBeTerminate);
-	}
-	/* make the child no longer child of its parent*/
+	pcb_PTR p = toBeTerminate;
+	pcb_PTR parent;
+
+	/* make the root no longer child of its parent*/
 	outChild(toBeTerminate);
-	pcb_PTR process_unblocked;
-	/*if terminated process is not blocked on our device semaphore */
-	if(toBeTerminate->p_semAdd < &device_sem[0] || toBeTerminate->p_semAdd > &device_sem[DEVINTNUM * DEVPERINT + DEVPERINT + 1 - 1]) {
-		process_unblocked = outBlocked(toBeTerminate);
-		if(process_unblocked != NULL) {
-			if((*toBeTerminate->p_semAdd) < 0) {
-				(*toBeTerminate->p_semAdd)++;
-			}
-		}
-	} else {
-		process_unblocked = outBlocked(toBeTerminate);
-		if(process_unblocked != NULL) {
-			softBlock_count--;
+
+	while(p != NULL) {
+		/* go down to a process without children */
+		if(!emptyChild(p)) {
+			p = p->p_child;
+			continue;
 		}
+		/* release it and go back up: p is the tail child, so outChild() finds it at once */
+		parent = p->p_prnt;
+		outChild(p);
+		helper_release_process(p);
+		p = parent;
 	}
-	/* if this pcb is in readyQ, take it out*/
-	outProcQ(&readyQ, toBeTerminate);
-	/* free the pcb and decrease process count*/
-	freePcb(toBeTerminate);
-	process_count--;
-	return;
 }
 
 /* System Calls Functions*/
@@ -222,17 +247,17 @@ HIDDEN void CREATEPROCESS() {
 	/* If no more free pcb’s return -1*/
 	if(newProcess == NULL) {
 		/* return an error code of -1 is placed/returned in the caller’s v0 */
-		((state_PTR)BIOSDATAPAGE)->s_v0 = -1;
-		return;
+		EXCSTATE->s_v0 = -1;
+		helper_non_blocking_syscall_handler();
 	}
 
 	/* deep copy the process state where a1 contain a pointer to a processor state (state t) */
-	deep_copy_state_t(&newProcess->p_s, ((state_PTR)BIOSDATAPAGE)->s_a1);
+	deep_copy_state_t(&newProcess->p_s, EXCSTATE->s_a1);
 
 	/* deep copy the support struct */
 	/* If no parameter is provided, this field is set to NULL. */
-	if(((state_PTR)BIOSDATAPAGE)->s_a2 != NULL & ((state_PTR)BIOSDATAPAGE)->s_a2 != 0) {
-		newProcess->p_supportStruct = ((state_PTR)BIOSDATAPAGE)->s_a2;
+	if(EXCSTATE->s_a2 != NULL & EXCSTATE->s_a2 != 0) {
+		newProcess->p_supportStruct = EXCSTATE->s_a2;
 	} else {
 		newProcess->p_supportStruct = NULL;
 	}
@@ -241,16 +266,17 @@ HIDDEN void CREATEPROCESS() {
 	The process queue fields (e.g. p next) by the call to insertProcQ
 •   The process tree fields (e.g. p child) by the call to insertChild.
 	*/
-	insertProcQ(&readyQ, newProcess);
+	make_ready(newProcess);
 	insertChild(currentP, newProcess);
 
 	/* return the value 0 in the caller’s v0 */
-	((state_PTR)BIOSDATAPAGE)->s_v0 = 0;
+	EXCSTATE->s_v0 = 0;
 
 	/* increase process count*/
 	process_count++;
 
 	/* p_time is set to 0 and p_semAdd is set to NULL in allocPcb() */
+	helper_non_blocking_syscall_handler();
 }
 
 /**********************************************************
@@ -292,7 +318,7 @@ HIDDEN void PASSEREN() {
 	*/
 
 	/* getting the sema4 address from register a1 */
-	int *sema4 = ((state_PTR)BIOSDATAPAGE)->s_a1;
+	int *sema4 = EXCSTATE->s_a1;
 
 	(*sema4)--;
 
@@ -311,29 +337,58 @@ HIDDEN void PASSEREN() {
  *
  *  Performs a V operation on the semaphore. If a process
  *  is blocked on the semaphore, it is unblocked and moved to
- *  the ready queue.
+ *  the ready queue. Control always returns to the caller.
  *
  *  Parameters:
  *
  *  Returns:
- *         pcb_PTR - Pointer to the unblocked process
+ *
  **********************************************************/
-HIDDEN pcb_PTR VERHOGEN() {
+HIDDEN void VERHOGEN() {
 	/*getting the sema4 address from register a1*/
-	int *sema4 = ((state_PTR)BIOSDATAPAGE)->s_a1;
+	int *sema4 = EXCSTATE->s_a1;
 
 	pcb_PTR process_unblocked;
 	(*sema4)++;
 
 	if((*sema4) <= 0) {
 		process_unblocked = removeBlocked(sema4);
-		if(process_unblocked == NULL) {
-			return NULL;
+		if(process_unblocked != NULL) {
+			make_ready(process_unblocked);
 		}
-		insertProcQ(&readyQ, process_unblocked);
-		return process_unblocked;
 	}
-	return NULL;
+	helper_non_blocking_syscall_handler();
+}
+
+/**********************************************************
+ *  helper_wait_device()
+ *
+ *  P operation on a device semaphore for the I/O operation
+ *  of the Current Process. If the interrupt was already taken
+ *  its status is returned at once, otherwise the process
+ *  blocks until the interrupt handler V's the semaphore.
+ *
+ *  Parameters:
+ *         int device_idx - index of the (sub)device semaphore
+ *
+ *  Returns:
+ *
+ **********************************************************/
+HIDDEN void helper_wait_device(int device_idx) {
+	helper_PASSEREN(&(device_sem[device_idx]));
+
+	/* the interrupt was already taken, possibly by another processor before this SYS5: hand back its status */
+	if(device_sem[device_idx] >= 0) {
+		EXCSTATE->s_v0 = device_status[device_idx];
+		helper_non_blocking_syscall_handler();
+	}
+
+	/* start of the block time recorded in the IOWAIT histogram */
+	STCK(currentP->p_ioStart);
+
+	softBlock_count++;
+
+	helper_blocking_syscall_handler();
 }
 
 /**********************************************************
@@ -363,13 +418,64 @@ HIDDEN void WAITIO() {
 	*/
 
 	/* must also update the Cause.IP field bits to show which interrupt lines are pending -- no, the hardware do this*/
-	int device_idx = devSemIdx(((state_PTR)BIOSDATAPAGE)->s_a1, ((state_PTR)BIOSDATAPAGE)->s_a2, ((state_PTR)BIOSDATAPAGE)->s_a3);
+	int device_idx = devSemIdx(EXCSTATE->s_a1, EXCSTATE->s_a2, EXCSTATE->s_a3);
 
-	helper_PASSEREN(&(device_sem[device_idx]));
+	helper_wait_device(device_idx);
+}
 
-	softBlock_count++;
+/**********************************************************
+ *  COMMANDWAIT()
+ *
+ *  Issues a command to a device and blocks the Current
+ *  Process until it completes, in one Nucleus entry. The
+ *  registers are written holding the Nucleus lock with
+ *  interrupts disabled, so the completion interrupt cannot
+ *  be served before the process is on the device semaphore.
+ *  A completion still pending from an earlier command is
+ *  dropped first. Returns the device status in v0, like SYS5.
+ *
+ *  a1: device, doioDev(line, device, terminal read)
+ *  a2: command, written to the (sub)device COMMAND field
+ *  a3: data0, written to DATA0 first (not for terminals)
+ *
+ *  Parameters:
+ *
+ *  Returns:
+ *
+ **********************************************************/
+HIDDEN void COMMANDWAIT() {
+	unsigned int device_idx = EXCSTATE->s_a1;
+	int intLineNo = DISKINT + device_idx / DEVPERINT;
+	int devNo = device_idx % DEVPERINT;
+	device_t *devAdd;
+
+	/* not a device: back to SYSCALL_handler, which raises a program trap */
+	if(device_idx >= pseudo_clock_idx) {
+		return;
+	}
 
-	return;
+	/* a completion nobody waited for belongs to an earlier command: drop it and
+	   its saved status, or helper_wait_device() would return it for this one */
+	if(device_sem[device_idx] > 0) {
+		device_sem[device_idx] = 0;
+	}
+	device_status[device_idx] = 0;
+
+	if(intLineNo > TERMINT) {
+		/* terminal receiver */
+		devAdd = devAddrBase(TERMINT, devNo);
+		devAdd->t_recv_command = EXCSTATE->s_a2;
+	} else if(intLineNo == TERMINT) {
+		devAdd = devAddrBase(TERMINT, devNo);
+		devAdd->t_transm_command = EXCSTATE->s_a2;
+	} else {
+		devAdd = devAddrBase(intLineNo, devNo);
+		devAdd->d_data0 = EXCSTATE->s_a3;
+		devAdd->d_command = EXCSTATE->s_a2;
+	}
+	trace_record(TRACE_IOSTART, hist_asid(currentP), device_idx, EXCSTATE->s_a2, EXCSTATE->s_a3);
+
+	helper_wait_device(device_idx);
 }
 
 /**********************************************************
@@ -387,8 +493,9 @@ HIDDEN void WAITIO() {
 HIDDEN void GETCPUTIME() {
 	/*the accumulated processor time (in microseconds) used by the requesting
 	process be placed/returned in the caller’s v0*/
-	((state_PTR)BIOSDATAPAGE)->s_v0 = currentP->p_time + 5000 - getTIMER();
-	return;
+	acct_charge_process();
+	EXCSTATE->s_v0 = currentP->p_time;
+	helper_non_blocking_syscall_handler();
 }
 
 /**********************************************************
@@ -412,7 +519,7 @@ HIDDEN void WAITCLOCK() {
 
 	softBlock_count++;
 
-	return;
+	helper_blocking_syscall_handler();
 }
 
 /**********************************************************
@@ -428,9 +535,108 @@ HIDDEN void WAITCLOCK() {
  *
  **********************************************************/
 HIDDEN void GETSUPPORTPTR() {
-	((state_PTR)BIOSDATAPAGE)->s_v0 = currentP->p_supportStruct;
+	EXCSTATE->s_v0 = currentP->p_supportStruct;
+	helper_non_blocking_syscall_handler();
+}
+
+/**********************************************************
+ *  SETEDFCLASS()
+ *
+ *  Moves the Current Process to the EDF scheduling class,
+ *  subject to admission control, or back to round-robin.
+ *  a1: period in us, 0 to leave the EDF class
+ *  a2: budget in us per period
+ *  a3: relative deadline in us, 0 for the period
+ *  v0: 0 if admitted, -1 if rejected
+ *
+ *  Parameters:
+ *
+ *  Returns:
+ *
+ **********************************************************/
+HIDDEN void SETEDFCLASS() {
+	if(EXCSTATE->s_a1 == 0) {
+		edf_leave(currentP);
+		EXCSTATE->s_v0 = 0;
+	} else {
+		EXCSTATE->s_v0 = edf_admit(currentP, EXCSTATE->s_a1, EXCSTATE->s_a2, EXCSTATE->s_a3);
+	}
+	helper_non_blocking_syscall_handler();
+}
+
+/**********************************************************
+ *  GETSTAT()
+ *
+ *  Returns a scheduling statistic of the Current Process.
+ *  a1: PSTAT_* statistic
+ *  v0: its value, -1 for an unknown statistic
+ *
+ *  Parameters:
+ *
+ *  Returns:
+ *
+ **********************************************************/
+HIDDEN void GETSTAT() {
+	switch(EXCSTATE->s_a1) {
+		case PSTAT_DLMISSES:
+			EXCSTATE->s_v0 = currentP->p_misses;
+			break;
+		case PSTAT_CPUTIME:
+			acct_charge_process();
+			EXCSTATE->s_v0 = currentP->p_time;
+			break;
+		case PSTAT_SWITCHES:
+			EXCSTATE->s_v0 = currentP->p_switches;
+			break;
+		case PSTAT_QUANTUM:
+			EXCSTATE->s_v0 = currentP->p_quantum;
+			break;
+		case PSTAT_ASID:
+			EXCSTATE->s_v0 = hist_asid(currentP);
+			break;
+		default:
+			EXCSTATE->s_v0 = -1;
+			break;
+	}
+	helper_non_blocking_syscall_handler();
 }
 
+/**********************************************************
+ *  SETSTRIDETICKETS()
+ *
+ *  Sets the stride scheduling tickets of the Current Process.
+ *  a1: tickets, 1 to STRIDE_MAX_TICKETS
+ *  v0: previous tickets, -1 if out of range
+ *
+ *  Parameters:
+ *
+ *  Returns:
+ *
+ **********************************************************/
+HIDDEN void SETSTRIDETICKETS() {
+	EXCSTATE->s_v0 = stride_set_tickets(currentP, EXCSTATE->s_a1);
+	helper_non_blocking_syscall_handler();
+}
+
+/* SYS1-SYS8 and SYS30-SYS33, indexed by the syscall number: every entry completes the call,
+   with a LDST straight from the BIOS Data Page or, when blocking, the scheduler.
+   Numbers between SUPPORTGET and DOIO belong to the Support Level */
+HIDDEN void (*const syscallTable[MAXNUCLEUSSYS + 1])() = {
+	NULL,
+	CREATEPROCESS,
+	TERMINATEPROCESS,
+	PASSEREN,
+	VERHOGEN,
+	WAITIO,
+	GETCPUTIME,
+	WAITCLOCK,
+	GETSUPPORTPTR,
+	[DOIO] = COMMANDWAIT,
+	[SETEDF] = SETEDFCLASS,
+	[GETPROCSTAT] = GETSTAT,
+	[SETTICKETS] = SETSTRIDETICKETS
+};
+
 /**********************************************************
  *  pass_up_or_die()
  *
@@ -453,8 +659,11 @@ HIDDEN void pass_up_or_die(int exception_constant) {
 	} else {
 		/* Copy the saved exception state from the BIOS Data Page to the correct sup exceptState field of the Current Process.
 		Perform a LDCXT using the fields from the correct sup exceptContextfield of the Current Process. */
-		deep_copy_state_t(&currentP->p_supportStruct->sup_exceptState[exception_constant], BIOSDATAPAGE);
-		LDCXT(currentP->p_supportStruct->sup_exceptContext[exception_constant].c_stackPtr, currentP->p_supportStruct->sup_exceptContext[exception_constant].c_status, currentP->p_supportStruct->sup_exceptContext[exception_constant].c_pc);
+		deep_copy_state_t(&currentP->p_supportStruct->sup_exceptState[exception_constant], EXCSTATE);
+		acct_charge_process();
+		context_t *passUpContext = &(currentP->p_supportStruct->sup_exceptContext[exception_constant]);
+		kernel_unlock();
+		LDCXT(passUpContext->c_stackPtr, passUpContext->c_status, passUpContext->c_pc);
 		/* NOTE: How did we have the context in the sup_exceptContext in the supportStruct of the current process? */
 	}
 }
@@ -462,9 +671,9 @@ HIDDEN void pass_up_or_die(int exception_constant) {
 /**********************************************************
  *  SYSCALL_handler()
  *
- *  Decodes and processes system calls (SYS1–SYS8). If an
- *  invalid system call is encountered, a program trap is
- *  triggered.
+ *  Decodes and processes system calls (SYS1–SYS8, SYS30–SYS33) through
+ *  syscallTable. If an invalid system call is encountered,
+ *  a program trap is triggered.
  *
  *  Parameters:
  *
@@ -475,10 +684,16 @@ HIDDEN void pass_up_or_die(int exception_constant) {
 HIDDEN void SYSCALL_handler() {
 	/*int syscall,state_t *statep, support_t * supportp, int arg3*/
 	/*check if in kernel mode -- if not and not SYSCALL 9+ either, put 10 for RI into exec code field in cause register and call program trap exception*/
+	unsigned int sysNo = EXCSTATE->s_a0;
+
+#ifdef PANDOS_DEBUG
+	trace_record(TRACE_SYSCALL, hist_asid(currentP), sysNo, EXCSTATE->s_a1, EXCSTATE->s_a2);
+#endif
+
 	if(check_KU_mode_bit() != 0) {
-		if(((state_PTR)BIOSDATAPAGE)->s_a0 <= 8) {
-			((state_PTR)BIOSDATAPAGE)->s_cause = ((state_PTR)BIOSDATAPAGE)->s_cause | 0x00000028;
-			((state_PTR)BIOSDATAPAGE)->s_cause = ((state_PTR)BIOSDATAPAGE)->s_cause & 0xFFFFFFEB;
+		if(sysNo <= SUPPORTGET || (sysNo >= DOIO && sysNo <= MAXNUCLEUSSYS)) {
+			EXCSTATE->s_cause = EXCSTATE->s_cause | 0x00000028;
+			EXCSTATE->s_cause = EXCSTATE->s_cause & 0xFFFFFFEB;
 		}
 
 		/* Program Traps */
@@ -486,35 +701,12 @@ HIDDEN void SYSCALL_handler() {
 		return;
 	}
 
-	switch(((state_PTR)BIOSDATAPAGE)->s_a0) {
-		case 1:
-			CREATEPROCESS();
-			helper_non_blocking_syscall_handler();
-		case 2:
-			TERMINATEPROCESS();
-			break;
-		case 3:
-			PASSEREN();
-			break;
-		case 4:
-			VERHOGEN();
-			helper_non_blocking_syscall_handler();
-		case 5:
-			WAITIO();
-			helper_blocking_syscall_handler();
-		case 6:
-			GETCPUTIME();
-			helper_non_blocking_syscall_handler();
-		case 7:
-			WAITCLOCK();
-			helper_blocking_syscall_handler();
-		case 8:
-			GETSUPPORTPTR();
-			helper_non_blocking_syscall_handler();
-		default:
-			/* Syscall Exception Error - Program trap handler */
-			pass_up_or_die(GENERALEXCEPT);
+	if(sysNo <= MAXNUCLEUSSYS && syscallTable[sysNo] != NULL) {
+		syscallTable[sysNo]();
 	}
+
+	/* Syscall Exception Error - Program trap handler */
+	pass_up_or_die(GENERALEXCEPT);
 }
 
 /**********************************************************
@@ -531,10 +723,21 @@ HIDDEN void SYSCALL_handler() {
  *
  **********************************************************/
 void exception_handler() {
+	kernel_lock();
+	cpus[getPRID()].c_idle = FALSE;
+
+	/* the time up to here was used by the Current Process (idle time if there is none) */
+	acct_charge_process();
+
 	/* Get the Cause registers from the saved exception state and
 	use AND bitwise operation to get the .ExcCode field */
 	/* decodes Cause.ExcCode */
-	int ExcCode = CauseExcCode(((state_PTR)BIOSDATAPAGE)->s_cause);
+	int ExcCode = CauseExcCode(EXCSTATE->s_cause);
+
+	/* the process was terminated by another processor while it was running here */
+	if(currentP == NULL && ExcCode != INT) {
+		scheduler();
+	}
 
 	switch(ExcCode) {
 		case INT:
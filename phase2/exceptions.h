@@ -8,11 +8,14 @@
 #ifndef EXCEPTIONS_H
 #define EXCEPTIONS_H
 
+#include "smp.h"
+
 extern int process_count;                                     /* Number of started processes */
 extern int softBlock_count;                                   /* Number of started that are in blocked */
-extern pcb_PTR readyQ;                                        /* Tail ptr to a queue of pcbs that are ready */
-extern pcb_PTR currentP;                                      /* Current Process */
+extern cpu_t kernelTime;                                      /* CPU time spent handling interrupts and scheduling */
+extern cpu_t idleTime;                                        /* time spent waiting for an interrupt */
 extern int device_sem[DEVINTNUM * DEVPERINT + DEVPERINT + 1]; /* Device Semaphores 49 semaphores in an array */
+extern int device_status[DEVINTNUM * DEVPERINT + DEVPERINT + 1]; /* status of an interrupt that came before its SYS5 */
 
 extern void uTLB_RefillHandler();
 
@@ -0,0 +1,95 @@
+/*********************************HISTOGRAM.C*******************************
+ *  Latency Histogram Module
+ *
+ *  This module keeps, for every ASID, log2 histograms of how long the
+ *  Nucleus and the Support Level spend servicing a U-proc:
+ *  - HIST_REFILL: TLB-Refill handler entry to LDST, only recorded by a
+ *    kernel built with -DPANDOS_DEBUG: it would slow down every refill.
+ *  - HIST_PGFAULT: Pager entry to its LDST.
+ *  - HIST_IOWAIT + class: time blocked on SYS5, per device class.
+ *
+ *  Samples are STCK deltas in microseconds. Bucket 0 holds 0 us and
+ *  bucket b holds [2^(b-1), 2^b) us; the last bucket also holds
+ *  everything longer. Index 0 is used for processes without an ASID.
+ *
+ *      Written by Phuong and Oghap on Oct 2026
+ */
+
+#include "../h/types.h"
+#include "../h/const.h"
+
+#include "histogram.h"
+
+latHist_t latencyHist[MAXUPROC + 1][HIST_KINDS];
+
+/**********************************************************
+ *  hist_record()
+ *
+ *  Adds one sample to a histogram of the given ASID.
+ *
+ *  Parameters:
+ *         int asid - ASID of the process, 0 if none
+ *         int kind - HIST_REFILL, HIST_PGFAULT or HIST_IOWAIT + class
+ *         cpu_t delta - sample in microseconds
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void hist_record(int asid, int kind, cpu_t delta) {
+	if(asid < 0 || asid > MAXUPROC) {
+		asid = 0;
+	}
+	latHist_t *hist = &(latencyHist[asid][kind]);
+
+	/* log2 bucket by shifting, no division */
+	int bucket = 0;
+	unsigned int value = delta;
+	while(value != 0 && bucket < HIST_BUCKETS - 1) {
+		value = value >> 1;
+		bucket++;
+	}
+
+	hist->h_count[bucket]++;
+	hist->h_samples++;
+	hist->h_total += delta;
+}
+
+/**********************************************************
+ *  hist_clear()
+ *
+ *  Resets all histograms of the given ASID.
+ *
+ *  Parameters:
+ *         int asid - ASID of the process, 0 if none
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void hist_clear(int asid) {
+	int kind, bucket;
+	for(kind = 0; kind < HIST_KINDS; kind++) {
+		for(bucket = 0; bucket < HIST_BUCKETS; bucket++) {
+			latencyHist[asid][kind].h_count[bucket] = 0;
+		}
+		latencyHist[asid][kind].h_samples = 0;
+		latencyHist[asid][kind].h_total = 0;
+	}
+}
+
+/**********************************************************
+ *  hist_asid()
+ *
+ *  Returns the ASID used to file the samples of a process.
+ *
+ *  Parameters:
+ *         pcb_PTR p - the process
+ *
+ *  Returns:
+ *         int - its ASID, 0 if it has no support structure
+ **********************************************************/
+int hist_asid(pcb_PTR p) {
+	if(p->p_supportStruct == NULL) {
+		return 0;
+	}
+	return p->p_supportStruct->sup_asid;
+}
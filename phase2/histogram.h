@@ -0,0 +1,19 @@
+/************************* HISTOGRAM.H *****************************
+ *
+ *  The externals declaration file for HISTOGRAM Module
+ *
+ *  Written by Phuong and Oghap on Oct 2026
+ */
+
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include "../h/pcb.h"
+
+extern latHist_t latencyHist[MAXUPROC + 1][HIST_KINDS]; /* per ASID latency histograms */
+
+void hist_record(int asid, int kind, cpu_t delta);
+void hist_clear(int asid);
+int hist_asid(pcb_PTR p);
+
+#endif
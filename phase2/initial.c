@@ -11,6 +11,7 @@
  *  - Initializing the Active Semaphore List (ASL) and Process Queue.
  *  - Instantiating the first process and placing it in the Ready Queue.
  *  - Loading the system-wide Interval Timer.
+ *  - Starting the other processors (see smp.c).
  *  - Ensuring the system enters the scheduler for process execution.
  *
  *      Modified by Phuong and Oghap on Feb 2025
@@ -24,15 +25,18 @@
 
 #include "exceptions.h"
 #include "scheduler.h"
+#include "histogram.h"
+#include "physMem.h"
 
 #include "initial.h"
 
 /* global variables*/
 int process_count;                                     /* Number of started processes */
 int softBlock_count;                                   /* Number of started that are in blocked */
-pcb_PTR readyQ;                                        /* Tail ptr to a queue of pcbs that are ready */
-pcb_PTR currentP;                                      /* Current Process */
+cpu_t kernelTime;                                      /* CPU time spent handling interrupts and scheduling */
+cpu_t idleTime;                                        /* time spent waiting for an interrupt */
 int device_sem[DEVINTNUM * DEVPERINT + DEVPERINT + 1]; /* Device Semaphores 49 semaphores in an array */
+int device_status[DEVINTNUM * DEVPERINT + DEVPERINT + 1]; /* status of an interrupt that came before its SYS5 */
 
 /**********************************************************
  *  main()
@@ -60,21 +64,39 @@ void main() {
 	/* Stack pointer for the Nucleus exception handler to the top of the Nucleus stack page: 0x2000.1000. */
 	passup_pro0->exception_stackPtr = (memaddr)(RAMSTART + PAGESIZE);
 
+	/* Frames past the kernel image, up to the stacks at RAMTOP */
+	initPhysMem();
+
 	/* Initialize pcbs and initASL*/
 	initASL();
 	initPcbs();
 
 	/* Initialize all Nucleus maintained variables */
+	int i;
 	process_count = 0;
 	softBlock_count = 0;
-	readyQ = mkEmptyProcQ();
-	currentP = NULL;
+	kernelTime = 0;
+	idleTime = 0;
+	kernelLock = 0;
+	for(i = 0; i < NCPU; i++) {
+		cpus[i].c_currentP = NULL;
+		cpus[i].c_pgDir = NULL;
+		cpus[i].c_readyQ = mkEmptyProcQ();
+		cpus[i].c_idle = FALSE;
+		cpus[i].c_fullSlice = FALSE;
+		STCK(cpus[i].c_acctStart);
+	}
 
 	/* Initalizing device semaphores to 0 */
-	int i;
 	int numberOfSemaphores = DEVINTNUM * DEVPERINT + DEVPERINT + 1;
 	for(i = 0; i < numberOfSemaphores; i++) {
 		device_sem[i] = 0;
+		device_status[i] = 0;
+	}
+
+	/* Start with empty latency histograms */
+	for(i = 0; i <= MAXUPROC; i++) {
+		hist_clear(i);
 	}
 
 	/* Load the system-wide Interval Timer with 100 milliseconds */
@@ -82,7 +104,8 @@ void main() {
 
 	/* Instantiate a single process, place its pcb in the Ready Queue, and increment Process Count. */
 	pcb_PTR first_pro = allocPcb();
-	insertProcQ(&readyQ, first_pro);
+	insertProcQ(&(cpus[0].c_readyQ), first_pro);
+	first_pro->p_state = PROC_READY;
 	process_count++;
 
 	/*  Interrupts enabled
@@ -105,6 +128,10 @@ void main() {
 
 	    COMPLETED in pcb.c */
 
+	/* Start the other processors; they wait for the Nucleus lock held from here to the first dispatch */
+	kernel_lock();
+	smp_start_cpus();
+
 	/* Call the Scheduler */
 	scheduler();
 }
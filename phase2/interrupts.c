@@ -4,15 +4,23 @@
  *  This module handles system interrupts.
  *  There are three main types: processor local timer (PLT), pseudo-clock,
  *  and device interrupts. The function interrupt_exception_handler()
- *  checks which interrupt occurred and calls the right function.
- *
- *  The code uses functions to handle different types of interrupts.
- *  process_local_timer_interrupts() manages the PLT by resetting the timer
- *  and putting the current process back in the ready queue.
+ *  serves every pending line, highest priority (lowest line number) first,
+ *  before a single return to the interrupted process.
+ *
+ *  Pending lines and pending devices of a line are picked with a priority
+ *  encoder (helper_priority_encode()) instead of testing each bit in turn.
+ *  process_local_timer_interrupts() manages the PLT by putting the current
+ *  process back in the ready queue; the scheduler reloads the timer. It runs
+ *  last, once the devices have been served. While profiling it also samples
+ *  the PC of the current process, and a sample period that ends inside the
+ *  time slice only reloads the timer (see prof.c).
+ *  Time spent handling an interrupt is charged to the kernel, not to the
+ *  process that happened to be running (see acct_charge_kernel()).
  *  pseudo_clock_interrupts() updates the pseudo-clock and unblocks waiting processes.
- *  non_timer_interrupts() checks which device caused an interrupt and processes it.
- *  It also has special handling for terminal devices using  helper_terminal_device()  and
- *  helper_non_terminal_device() .
+ *  non_timer_interrupts() acknowledges every pending device of a line, re-reading
+ *  the Interrupting Devices Bit Map until it is clear, with
+ *  helper_terminal_device() and helper_non_terminal_device().
+ *  Inter-processor interrupts are handed to ipi_receive() (smp.c).
  *
  *  The code uses arrays to store device semaphores and linked lists to manage process queues.
  *  It also updates the process state and may call the scheduler when needed.
@@ -29,13 +37,19 @@
 #include "scheduler.h"
 #include "exceptions.h"
 #include "initial.h"
+#include "histogram.h"
+#include "trace.h"
+#include "prof.h"
 
 #include "interrupts.h"
 
 #define pseudo_clock_idx 48 /* pseudo clock semaphore in device semaphore array*/
 #define IPBITSPOS 8         /* Interrupt pending bits position*/
-#define INTLINESCOUNT 8     /* number of interrupt lines*/
-#define REGWIDTH 32         /* register width*/
+#define NIBBLEMASK 0xF      /* 4 bits looked up at once by the priority encoder*/
+#define NIBBLELEN 4
+
+/* index of the lowest set bit of a 4 bit value, -1 if none */
+HIDDEN const int lowestSetBit[16] = {-1, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0};
 
 /**********************************************************
  *  helper_verhogen()
@@ -45,14 +59,12 @@
  *  the ready queue.
  *
  *  Parameters:
+ *         int *sema4 - Pointer to the semaphore to increment
  *
  *  Returns:
  *         pcb_PTR - Pointer to the unblocked process
  **********************************************************/
-pcb_PTR helper_verhogen() {
-	/*getting the sema4 address from register a1*/
-	int *sema4 = ((state_PTR)BIOSDATAPAGE)->s_a1;
-
+HIDDEN pcb_PTR helper_verhogen(int *sema4) {
 	pcb_PTR process_unblocked;
 	(*sema4)++;
 
@@ -61,85 +73,54 @@ pcb_PTR helper_verhogen() {
 		if(process_unblocked == NULL) {
 			return NULL;
 		}
-		insertProcQ(&readyQ, process_unblocked);
+		make_ready(process_unblocked);
 		return process_unblocked;
 	}
 	return NULL;
 }
 
 /**********************************************************
- *  deep_copy_state_t()
+ *  helper_return_to_current()
  *
- *  Deep copies the contents of a source processor state into a
- *  destination processor state.
+ *  Ends the handling of an interrupt: the time spent since
+ *  the process was charged goes to the kernel, and control
+ *  returns to the interrupted process, or to the scheduler
+ *  if the processor was idle.
  *
  *  Parameters:
- *         state_PTR dest - Pointer to the destination state
- *         state_PTR src  - Pointer to the source state
  *
  *  Returns:
  *
  **********************************************************/
-HIDDEN void deep_copy_state_t(state_PTR dest, state_PTR src) {
-	dest->s_cause = src->s_cause;
-	dest->s_entryHI = src->s_entryHI;
-	dest->s_pc = src->s_pc;
-	int i;
-	for(i = 0; i < STATEREGNUM; i++) {
-		dest->s_reg[i] = src->s_reg[i];
-	}
-	dest->s_status = src->s_status;
-}
-
-/**********************************************************
- *  helper_check_interrupt_line()
- *
- *  Takes in a line number and check if there is interrupt pending
- *  on that line by checking on the cause register.
- *
- *  Parameters:
- *         int idx - line number
- *
- *  Returns:
- *          TRUE
- *          FALSE
- **********************************************************/
-HIDDEN int helper_check_interrupt_line(int idx) {
-	/* Get the IP bit from cause registers then shift right to get the interrupt line which*/
-	/* in binary, 1 bits indicate line with interrupt pending -- this is Cause.IP*/
-	int IPLines = (((state_PTR)BIOSDATAPAGE)->s_cause & IPBITS) >> IPBITSPOS;
-
-	/* 31 as the size of int is 32 bits (4 bytes)*/
-	if((IPLines << (REGWIDTH - 1 - idx)) >> (REGWIDTH - 1) == 0) {
-		return FALSE;
+HIDDEN void helper_return_to_current() {
+	if(currentP == NULL) {
+		scheduler();
 	}
-	return TRUE;
+	acct_charge_kernel();
+	kernel_unlock();
+	/* Perform a LDST on the saved exception state*/
+	LDST(EXCSTATE);
 }
 
 /**********************************************************
- *  helper_check_interrupt_device()
+ *  helper_priority_encode()
  *
- *  Checks if a device has interrupt pending by taking in a
- *  device number and address of the Line Interrupt
- *  Device Bit Map. Calculates by using device register bits.
+ *  Priority encoder over an 8 bit pending mask (Cause.IP or
+ *  an Interrupting Devices Bit Map): returns the lowest set
+ *  bit, i.e. the highest priority line or device, with two
+ *  table lookups instead of a shift per bit.
  *
  *  Parameters:
- *         int idx - device number
- *         int* devRegAdd - address of the Line Interrupt
- *                          Device Bit Map
+ *         unsigned int bits - non-zero pending mask
  *
  *  Returns:
- *          TRUE
- *          FALSE
+ *         int - index of the lowest set bit
  **********************************************************/
-HIDDEN int helper_check_interrupt_device(int idx, int *devRegAdd) {
-	/* loop through the devices on each line*/
-	int devBits = *devRegAdd;
-	/* 31 as the size of int is 32 bits (4 bytes)*/
-	if((devBits << (REGWIDTH - 1 - idx)) >> (REGWIDTH - 1) == 0) {
-		return FALSE;
+HIDDEN int helper_priority_encode(unsigned int bits) {
+	if((bits & NIBBLEMASK) != 0) {
+		return lowestSetBit[bits & NIBBLEMASK];
 	}
-	return TRUE;
+	return NIBBLELEN + lowestSetBit[(bits >> NIBBLELEN) & NIBBLEMASK];
 }
 
 /**********************************************************
@@ -165,76 +146,96 @@ HIDDEN pcb_PTR helper_unblock_process(int *semdAdd) {
 }
 
 /**********************************************************
- *  helper_terminal_device()
+ *  helper_record_iowait()
  *
- *  Acknowledge interrupts from terminal read sub-device.
- *  Performs a V operation on the device semaphore
- *  and unblocks waiting process if needed
+ *  Files the time a process spent blocked on SYS5 in the
+ *  IOWAIT histogram of its device class.
  *
  *  Parameters:
+ *         pcb_PTR unblocked_pcb - the process just unblocked
  *         int intLineNo - Interrupt line number
- *         int devNo  - Device Number
  *
  *  Returns:
  *
  **********************************************************/
-HIDDEN void helper_terminal_device(int intLineNo, int devNo, int termRead) {
-	/* Calculate the address for this device’s device register */
-	device_t *intDevRegAdd = devAddrBase(intLineNo, devNo);
-	int savedDevRegStatus;
-
-	if(termRead) {
-		/* Save off the status code from the device’s device register*/
-		savedDevRegStatus = intDevRegAdd->t_recv_status; /* should be the char and 5 for CHAR RECEIVED*/ /* we want this because after acknowledged, anything will become Device Ready, even if the action did not succeed*/
-		/* Acknowledge the outstanding interrupt */
-		intDevRegAdd->t_recv_command = ACK;
-	} else {
-		/* Save off the status code from the device’s device register*/
-		savedDevRegStatus = intDevRegAdd->t_transm_status; /* should be the char and 5 for CHAR TRANSMITTED*/ /* we want this because after acknowledged, anything will become Device Ready, even if the action did not succeed*/
-		/* Acknowledge the outstanding interrupt */
-		intDevRegAdd->t_transm_command = ACK;
-	}
-
-	/* Perform a V operation on the Nucleus maintained semaphore associated with this (sub)device.*/
-	int devIdx = devSemIdx(intLineNo, devNo, termRead);
-
-	/* put semdAdd into BIOSDATAPAGE state register a1 to call VERHOGEN -- VERHOGEN use the state in currentP*/
-	((state_PTR)BIOSDATAPAGE)->s_a1 = &device_sem[devIdx];
+HIDDEN void helper_record_iowait(pcb_PTR unblocked_pcb, int intLineNo) {
+	cpu_t now;
+	STCK(now);
+	hist_record(hist_asid(unblocked_pcb), HIST_IOWAIT + intLineNo - DISKINT, now - unblocked_pcb->p_ioStart);
+}
 
-	/* putting the process returned by V operation to unblocked_pcb */
-	pcb_PTR unblocked_pcb = helper_verhogen();
+/**********************************************************
+ *  helper_device_done()
+ *
+ *  Performs a V operation on the semaphore of a (sub)device
+ *  whose interrupt was acknowledged. The unblocked process
+ *  gets the saved status in v0; with no waiting process the
+ *  status is kept for the SYS5 still to come.
+ *
+ *  Parameters:
+ *         int intLineNo - Interrupt line number
+ *         int devIdx - index of the device semaphore
+ *         int savedDevRegStatus - status before the acknowledgement
+ *
+ *  Returns:
+ *
+ **********************************************************/
+HIDDEN void helper_device_done(int intLineNo, int devIdx, int savedDevRegStatus) {
+	pcb_PTR unblocked_pcb = helper_verhogen(&device_sem[devIdx]);
 
-	/* if V operation failed to remove a pcb then return control to the current process*/
 	if(unblocked_pcb == NULL) {
-		/* if there is no current process to return to either, call scheduler*/
-		if(currentP == NULL) {
-			scheduler();
-		}
-		LDST((state_PTR)BIOSDATAPAGE);
+		trace_record(TRACE_IODONE, 0, devIdx, savedDevRegStatus, 0);
+		device_status[devIdx] = savedDevRegStatus;
+		return;
 	}
+	trace_record(TRACE_IODONE, hist_asid(unblocked_pcb), devIdx, savedDevRegStatus, 0);
 	softBlock_count--;
 
 	/* Place the stored off status code in the newly unblocked pcb’s v0 register.*/
 	unblocked_pcb->p_s.s_v0 = savedDevRegStatus;
+	helper_record_iowait(unblocked_pcb, intLineNo);
+}
 
-	/* Insert the newly unblocked pcb on the Ready Queue*/
-	/* Done in helper_verhogen()*/
-	/* if there is no current process to return to either, call scheduler*/
-	if(currentP == NULL) {
-		scheduler();
+/**********************************************************
+ *  helper_terminal_device()
+ *
+ *  Acknowledges one pending terminal sub-device, transmission
+ *  first as it has the higher priority, and V's its semaphore.
+ *  A terminal with both sub-devices pending stays set in the
+ *  bit map and is served again by the caller.
+ *
+ *  Parameters:
+ *         int devNo  - Device Number
+ *
+ *  Returns:
+ *
+ **********************************************************/
+HIDDEN void helper_terminal_device(int devNo) {
+	/* Calculate the address for this device’s device register */
+	device_t *intDevRegAdd = devAddrBase(TERMINT, devNo);
+	int savedDevRegStatus = intDevRegAdd->t_transm_status;
+	int termRead = FALSE;
+
+	/* a sub-device that is neither ready nor busy has completed an operation */
+	if((savedDevRegStatus & TERMSTATMASK) != READY && (savedDevRegStatus & TERMSTATMASK) != BUSY) {
+		/* Acknowledge the outstanding interrupt */
+		intDevRegAdd->t_transm_command = ACK;
+	} else {
+		termRead = TRUE;
+		savedDevRegStatus = intDevRegAdd->t_recv_status;
+		intDevRegAdd->t_recv_command = ACK;
 	}
-	/* Perform a LDST on the saved exception state*/
-	LDST((state_PTR)BIOSDATAPAGE);
+
+	/* Perform a V operation on the Nucleus maintained semaphore associated with this sub-device.*/
+	int devIdx = devSemIdx(TERMINT, devNo, termRead);
+	helper_device_done(TERMINT, devIdx, savedDevRegStatus);
 }
 
 /**********************************************************
  *  helper_non_terminal_device()
  *
- *  Aknowledge interrupts from terminal write sub-device
- *  or other devices. Performs a V operation on the device
- *  semaphore and unblocks waiting process if needed.
- *  When V operation fails to remove a pcb, it
- *  returns control to the current process.
+ *  Acknowledges the interrupt of a non-terminal device and
+ *  V's its semaphore.
  *
  *  Parameters:
  *         int intLineNo - Interrupt line number
@@ -253,36 +254,9 @@ HIDDEN void helper_non_terminal_device(int intLineNo, int devNo) {
 	/* Acknowledge the outstanding interrupt */
 	intDevRegAdd->d_command = ACK;
 
-	/* Perform a V operation on the Nucleus maintained semaphore associated with this (sub)device.*/
+	/* Perform a V operation on the Nucleus maintained semaphore associated with this device.*/
 	int devIdx = devSemIdx(intLineNo, devNo, FALSE);
-
-	/* put semdAdd into BIOSDATAPAGE state register a1 to call VERHOGEN -- VERHOGEN use the semdAdd in reg a1 of the state saved*/
-	((state_PTR)BIOSDATAPAGE)->s_a1 = &device_sem[devIdx];
-
-	/* putting the process returned by V operation to unblocked_pcb */
-	pcb_PTR unblocked_pcb = helper_verhogen();
-
-	/* if V operation failed to remove a pcb then return control to the current process*/
-	if(unblocked_pcb == NULL) {
-		/* if there is no current process to return to either, call scheduler*/
-		if(currentP == NULL) {
-			scheduler();
-		}
-		LDST((state_PTR)BIOSDATAPAGE);
-	}
-	softBlock_count--;
-
-	/* Place the stored off status code in the newly unblocked pcb’s v0 register.*/
-	unblocked_pcb->p_s.s_v0 = savedDevRegStatus;
-
-	/* Insert the newly unblocked pcb on the Ready Queue*/
-	/* Done in helper_verhogen()*/
-
-	if(currentP == NULL) {
-		scheduler();
-	}
-	/* Perform a LDST on the saved exception state*/
-	LDST((state_PTR)BIOSDATAPAGE);
+	helper_device_done(intLineNo, devIdx, savedDevRegStatus);
 }
 
 /* Interrupts */
@@ -290,10 +264,11 @@ HIDDEN void helper_non_terminal_device(int intLineNo, int devNo) {
 /**********************************************************
  *  process_local_timer_interrupts()
  *
- *  Resets timer to 5 miliseconds and copies the processor
- *  state from BIOS. Updates CPU time and moves the
+ *  Copies the processor state from BIOS and moves the
  *  current process to the ready queue, then calls
- *  scheduler.
+ *  scheduler, which reloads the timer. If only a sample
+ *  period of the profiler ended, the process keeps running
+ *  for the rest of its time slice.
  *
  *  Parameters:
  *
@@ -301,16 +276,21 @@ HIDDEN void helper_non_terminal_device(int intLineNo, int devNo) {
  *
  **********************************************************/
 HIDDEN void process_local_timer_interrupts() {
-	/* load new time into timer for PLT*/
-	setTIMER(5000);
 	/* copy the processor state at the time of the exception into current process*/
 	if(currentP != NULL) {
-		deep_copy_state_t(&(currentP->p_s), (state_PTR)BIOSDATAPAGE);
+		prof_sample(EXCSTATE, hist_asid(currentP));
+		if(cpus[getPRID()].c_sliceLeft > 0) {
+			/* time slice not over yet: helper_return_to_current() resumes the process */
+			setTIMER(prof_arm(cpus[getPRID()].c_sliceLeft));
+			return;
+		}
+		deep_copy_state_t(&(currentP->p_s), EXCSTATE);
+		/* it used its slice up: a longer one next time */
+		quantum_adapt(currentP, TRUE);
+		/* place current process on ready queue*/
+		make_ready(currentP);
 	}
-	/* update accumulated CPU time for the current process*/
-	currentP->p_time += 5000 - getTIMER();
-	/* place current process on ready queue*/
-	insertProcQ(&readyQ, currentP);
+	/* the CPU time was charged on exception entry; the scheduler reloads the PLT */
 	scheduler();
 }
 
@@ -318,8 +298,7 @@ HIDDEN void process_local_timer_interrupts() {
  *  pseudo_clock_interrupts()
  *
  *  Reloads timer and unblocks all pcb that was blocked on
- *  pseudo-clock. Resets the psuedo-clock semaphore and
- *  returns control to the current process.
+ *  pseudo-clock. Resets the psuedo-clock semaphore.
  *
  *  Parameters:
  *
@@ -333,24 +312,20 @@ HIDDEN void pseudo_clock_interrupts() {
 	pcb_PTR unblocked_pcb = helper_unblock_process(pseudo_clock_sem);
 	/*unblock all pcb blocked on the Pseudo-clock*/
 	while(unblocked_pcb != NULL) {
-		insertProcQ(&readyQ, unblocked_pcb);
+		make_ready(unblocked_pcb);
 		unblocked_pcb = helper_unblock_process(pseudo_clock_sem);
 	}
 	/* reset pseudo-clock semaphore to 0*/
 	*(pseudo_clock_sem) = 0;
-	if(currentP == NULL) {
-		scheduler();
-	}
-	/* return control to the current process*/
-	LDST((state_t *)BIOSDATAPAGE);
 }
 
 /**********************************************************
  *  non_timer_interrupts()
  *
- *  Identifies the device that caused the interrupt and
- *  processes it accordingly. Checks in Interrupting Devices
- *  Bit Map of that line to see if the device has interrupt.
+ *  Serves every device with an interrupt pending on a line,
+ *  highest priority first. The Interrupting Devices Bit Map
+ *  is read again after each acknowledgement, so devices that
+ *  complete meanwhile are served in the same pass.
  *
  *  Parameters:
  *          int intLineNo - Line Number
@@ -358,34 +333,17 @@ HIDDEN void pseudo_clock_interrupts() {
  *
  **********************************************************/
 HIDDEN void non_timer_interrupts(int intLineNo) {
-	/*  Calculate the address for Interrupting Devices Bit Map of that Line. */
-
-	/*  After knowing which line specifically, find which pending interrupt on that line
-	    Value at Interrupting Devices Bit Map in binary has a bit as 1 if that device has interrupt pending */
+	/*  Value at Interrupting Devices Bit Map in binary has a bit as 1 if that device has interrupt pending */
 	int *intLineDevBitMap = intDevBitMap(intLineNo);
-
-	/* Boolean to later store whether the device has interrupt*/
-	int devIntBool;
-
-	/* address of register of device with interrupt pending*/
-	device_t *intDevRegAdd;
-
-	/* looping through every bit 0-7 to see if the device has interrupt*/
+	unsigned int pendingDevs;
 	int devNo;
-	for(devNo = 0; devNo < DEVPERINT; devNo++) {
-		/* check in Interrupting Devices Bit Map of that line to see if the device has interrupt */
-		devIntBool = helper_check_interrupt_device(devNo, intLineDevBitMap);
-
-		if(devIntBool == TRUE) {
-			/* address of register of device*/
-			intDevRegAdd = devAddrBase(intLineNo, devNo);
-
-			if(intLineNo != 7) {
-				helper_non_terminal_device(intLineNo, devNo);
-			} else {
-				int termRead = (((intDevRegAdd->d_status) & 0x000000FF) == 5);
-				helper_terminal_device(intLineNo, devNo, termRead);
-			}
+
+	while((pendingDevs = (*intLineDevBitMap) & CAUSEMASK) != 0) {
+		devNo = helper_priority_encode(pendingDevs);
+		if(intLineNo == TERMINT) {
+			helper_terminal_device(devNo);
+		} else {
+			helper_non_terminal_device(intLineNo, devNo);
 		}
 	}
 }
@@ -393,9 +351,11 @@ HIDDEN void non_timer_interrupts(int intLineNo) {
 /**********************************************************
  *  interrupt_exception_handler()
  *
- *  Determines the pending interrupt line and delegates to
- *  the appropriate handler such as process local timer,
- *  pseudo-clock, and devices interrupt handler.
+ *  Serves every pending interrupt line, highest priority
+ *  first: inter-processor interrupts, pseudo-clock and all
+ *  pending devices. A PLT expiry is acted on last, so the
+ *  preemption does not delay the devices; otherwise control
+ *  returns once to the interrupted process.
  *
  *  Parameters:
  *
@@ -403,11 +363,18 @@ HIDDEN void non_timer_interrupts(int intLineNo) {
  *
  **********************************************************/
 void interrupt_exception_handler() {
+	/* in binary, 1 bits indicate line with interrupt pending -- this is Cause.IP*/
+	unsigned int pendingLines = (EXCSTATE->s_cause & IPBITS) >> IPBITSPOS;
+	int pltExpired = FALSE;
 	int lineNum;
-	int lineIntBool;
-	/* loop through the interrupt line for devices*/
-	for(lineNum = 0; lineNum < INTLINESCOUNT; lineNum++) {
-		lineIntBool = helper_check_interrupt_line(lineNum);
+
+#ifdef PANDOS_DEBUG
+	trace_record(TRACE_INTERRUPT, (currentP != NULL) ? hist_asid(currentP) : 0, pendingLines, 0, 0);
+#endif
+
+	while(pendingLines != 0) {
+		lineNum = helper_priority_encode(pendingLines);
+		pendingLines &= ~(1 << lineNum);
 
 		/*
 		Interrupt line 0 is reserved for inter-processor interrupts.
@@ -415,32 +382,28 @@ void interrupt_exception_handler() {
 		Line 2 is reserved for system-wide Interval Timer interrupts.
 		Interrupt lines 3–7 are for monitoring interrupts from peripheral devices
 		*/
-		if(lineIntBool == TRUE) {
-			switch(lineNum) {
-				case INTERPROCESSORINT:
-					/*processor interrupt -- pandos is only for uniprocessor -- this case will not happen -- can safely ignore -- delete later*/
-					break;
-				case PLTINT:
-					/*processor local timer (PLT) interrupt*/
-					process_local_timer_interrupts();
-				case INTERVALTIMERINT:
-					/*interval timer interrupt*/
-					pseudo_clock_interrupts();
-				case DISKINT:
-				case FLASHINT:
-				case NETWINT:
-				case PRNTINT:
-				case TERMINT:
-					/*device interrupt*/
-					non_timer_interrupts(lineNum);
-				default:
-					break;
-			}
+		switch(lineNum) {
+			case INTERPROCESSORINT:
+				/*inter-processor interrupt: a wakeup or a TLB flush request*/
+				ipi_receive();
+				break;
+			case PLTINT:
+				/*processor local timer (PLT) interrupt*/
+				pltExpired = TRUE;
+				break;
+			case INTERVALTIMERINT:
+				/*interval timer interrupt*/
+				pseudo_clock_interrupts();
+				break;
+			default:
+				/*device interrupt*/
+				non_timer_interrupts(lineNum);
+				break;
 		}
 	}
-	if(currentP == NULL) {
-		scheduler();
+
+	if(pltExpired == TRUE) {
+		process_local_timer_interrupts();
 	}
-	/* return control to the current process*/
-	LDST((state_t *)BIOSDATAPAGE);
+	helper_return_to_current();
 }
@@ -0,0 +1,222 @@
+/*********************************P2BENCH.C*******************************
+ *
+ *	Benchmark program for the Nucleus, linked in place of p2test.c
+ *	(make bench builds benchkernel.core.umps).
+ *
+ *	Times thousands of iterations of each Nucleus service with the TOD
+ *	clock and writes one CSV line per benchmark on Printer0:
+ *
+ *	    bench,iterations,total_us,ns_per_op
+ *
+ *	so that the printer files of two runs can be compared across
+ *	commits. The benchmarks are
+ *	- sys3_sys4_uncontended: P then V of a free semaphore;
+ *	- sys3_sys4_contended: P then V of one mutex by two processes, each
+ *	  P blocking on the mutex held by the other and each V handing it
+ *	  over: the holder lets the other one wait for the mutex, through
+ *	  a second semaphore, before releasing it. One op is a P/V pair of
+ *	  either on the mutex plus one on the second semaphore. The contender
+ *	  only reaches its P before the driver's V because there is one
+ *	  processor (phase2 builds with NCPU 1): on more, some of its P's may
+ *	  find the mutex free;
+ *	- sys6_getcputime, sys8_getsupportptr: one call;
+ *	- sys1_sys2_create_terminate: creating a process that terminates
+ *	  itself, until its parent is told so;
+ *	- pingpong_roundtrip: two processes waking each other through two
+ *	  semaphores, two context switches per op.
+ *
+ *	The TLB-Refill and page fault times need the Support Level, see
+ *	phase3/testers/vmBench.c.
+ *
+ *      Written by Phuong and Oghap on Oct 2026
+ */
+
+#include "../h/const.h"
+#include "../h/types.h"
+#include "/usr/include/umps3/umps/libumps.h"
+
+#define ITERATIONS 5000
+#define CREATIONS 1000 /* SYS1/SYS2 are slower */
+
+#define CAUSEINTMASK 0xFD00
+#define PRINTER0 doioDev(PRNTINT, 0, FALSE)
+
+/* just to be clear */
+#define SEMAPHORE int
+
+SEMAPHORE benchMutex = 1, /* P/V'd by the contended benchmark */
+  mainTurn = 0,           /* the contender waits for the mutex */
+  contenderTurn = 0,      /* the benchmark driver holds the mutex */
+  pingSem = 0,            /* wakes the pong process */
+  pongSem = 0,            /* wakes the benchmark back */
+  childDone = 0;          /* a child process is about to end */
+
+state_t contenderState, pongState, shortLivedState;
+
+void contender(), pong(), shortLived();
+
+/* writes a string on Printer0 */
+void printCsv(char *msg) {
+	while(*msg != EOS) {
+		if(SYSCALL(DOIO, PRINTER0, PRINTCHR, *msg) != READY) {
+			PANIC();
+		}
+		msg++;
+	}
+}
+
+/* writes an unsigned number in decimal on Printer0 */
+void printCsvNum(unsigned int num) {
+	char buf[11];
+	int i = 10;
+
+	buf[i] = EOS;
+	do {
+		i--;
+		buf[i] = '0' + (num % 10);
+		num = num / 10;
+	} while(num != 0);
+	printCsv(&buf[i]);
+}
+
+/* writes the CSV line of a benchmark */
+void report(char *name, unsigned int iterations, cpu_t start, cpu_t end) {
+	unsigned int total = end - start;
+
+	printCsv(name);
+	printCsv(",");
+	printCsvNum(iterations);
+	printCsv(",");
+	printCsvNum(total);
+	printCsv(",");
+	/* total * 1000 would overflow past 4.29 s */
+	printCsvNum((total / iterations) * 1000 + ((total % iterations) * 1000) / iterations);
+	printCsv("\n");
+}
+
+/* TLB-Refill Handler, never called: no process has a support structure */
+void uTLB_RefillHandler() {
+	setENTRYHI(0x80000000);
+	setENTRYLO(0x00000000);
+	TLBWR();
+
+	LDST((state_PTR)0x0FFFF000);
+}
+
+/* sets up the state of a process running f with its own stack below sp */
+void initState(state_t *s, memaddr sp, void (*f)()) {
+	STST(s);
+	s->s_sp = sp;
+	s->s_pc = s->s_t9 = (memaddr)f;
+	s->s_status = s->s_status | IEPBITON | CAUSEINTMASK | TEBITON;
+}
+
+/*********************************************************************/
+/*                                                                   */
+/*                 test -- the benchmark driver                      */
+/*                                                                   */
+void test() {
+	state_t self;
+	cpu_t start, end;
+	int i;
+
+	STST(&self);
+	initState(&contenderState, self.s_sp - QPAGE, contender);
+	initState(&pongState, self.s_sp - 2 * QPAGE, pong);
+	initState(&shortLivedState, self.s_sp - 3 * QPAGE, shortLived);
+
+	printCsv("bench,iterations,total_us,ns_per_op\n");
+
+	STCK(start);
+	for(i = 0; i < ITERATIONS; i++) {
+		SYSCALL(PASSERN, (int)&benchMutex, 0, 0);
+		SYSCALL(VERHO, (int)&benchMutex, 0, 0);
+	}
+	STCK(end);
+	report("sys3_sys4_uncontended", ITERATIONS, start, end);
+
+	/* both processes loop on the mutex, each releasing it only once the
+	   other waits for it, so that no P gets it free on one processor:
+	   the contender runs on from its V of mainTurn to its P of the mutex
+	   before the driver gets the processor back; the contender tells
+	   when it is done */
+	SYSCALL(CREATETHREAD, (int)&contenderState, (int)NULL, 0);
+	STCK(start);
+	for(i = 0; i < ITERATIONS; i++) {
+		SYSCALL(PASSERN, (int)&benchMutex, 0, 0);
+		SYSCALL(VERHO, (int)&contenderTurn, 0, 0);
+		SYSCALL(PASSERN, (int)&mainTurn, 0, 0);
+		SYSCALL(VERHO, (int)&benchMutex, 0, 0);
+	}
+	SYSCALL(PASSERN, (int)&childDone, 0, 0);
+	STCK(end);
+	report("sys3_sys4_contended", 2 * ITERATIONS, start, end);
+
+	STCK(start);
+	for(i = 0; i < ITERATIONS; i++) {
+		SYSCALL(CPUTIMEGET, 0, 0, 0);
+	}
+	STCK(end);
+	report("sys6_getcputime", ITERATIONS, start, end);
+
+	STCK(start);
+	for(i = 0; i < ITERATIONS; i++) {
+		SYSCALL(SUPPORTGET, 0, 0, 0);
+	}
+	STCK(end);
+	report("sys8_getsupportptr", ITERATIONS, start, end);
+
+	STCK(start);
+	for(i = 0; i < CREATIONS; i++) {
+		SYSCALL(CREATETHREAD, (int)&shortLivedState, (int)NULL, 0);
+		SYSCALL(PASSERN, (int)&childDone, 0, 0);
+	}
+	STCK(end);
+	report("sys1_sys2_create_terminate", CREATIONS, start, end);
+
+	SYSCALL(CREATETHREAD, (int)&pongState, (int)NULL, 0);
+	STCK(start);
+	for(i = 0; i < ITERATIONS; i++) {
+		SYSCALL(VERHO, (int)&pingSem, 0, 0);
+		SYSCALL(PASSERN, (int)&pongSem, 0, 0);
+	}
+	STCK(end);
+	report("pingpong_roundtrip", ITERATIONS, start, end);
+
+	/* the pong process ended after its last round: the Nucleus halts */
+	SYSCALL(TERMINATETHREAD, 0, 0, 0);
+}
+
+/* contender -- the other side of sys3_sys4_contended */
+void contender() {
+	int i;
+
+	for(i = 0; i < ITERATIONS; i++) {
+		SYSCALL(PASSERN, (int)&contenderTurn, 0, 0);
+		SYSCALL(VERHO, (int)&mainTurn, 0, 0);
+		/* held by the benchmark driver until we wait for it */
+		SYSCALL(PASSERN, (int)&benchMutex, 0, 0);
+		SYSCALL(VERHO, (int)&benchMutex, 0, 0);
+	}
+	SYSCALL(VERHO, (int)&childDone, 0, 0);
+	SYSCALL(TERMINATETHREAD, 0, 0, 0);
+}
+
+/* pong -- answers every ping of pingpong_roundtrip */
+void pong() {
+	int i;
+
+	for(i = 0; i < ITERATIONS; i++) {
+		SYSCALL(PASSERN, (int)&pingSem, 0, 0);
+		SYSCALL(VERHO, (int)&pongSem, 0, 0);
+	}
+	SYSCALL(TERMINATETHREAD, 0, 0, 0);
+}
+
+/* shortLived -- created and gone for sys1_sys2_create_terminate; every
+   incarnation reuses the same stack, which the previous one no longer
+   touches once its V is done */
+void shortLived() {
+	SYSCALL(VERHO, (int)&childDone, 0, 0);
+	SYSCALL(TERMINATETHREAD, 0, 0, 0);
+}
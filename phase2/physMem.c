@@ -0,0 +1,91 @@
+/*********************************PHYSMEM.C*******************************
+ *  Physical Frame Allocator
+ *
+ *  Hands out the RAM frames between the end of the kernel image and the
+ *  stacks at the top of RAM, in order, at boot. The installed RAM is read
+ *  from the Bus registers (RAMBASEADDR, RAMBASESIZE) and the end of the
+ *  kernel image, .bss included, from the _end symbol of the linker
+ *  script. Frames are never given back.
+ *
+ *  The Nucleus takes the stacks of the secondary processors; the Support
+ *  Level then takes the DMA buffers, the compressed swap tier, the swap
+ *  pool table and, last, every frame left as the swap pool. Frames are
+ *  only taken by processor 0 before the first dispatch or by test()
+ *  before it creates the U-procs, so no lock is needed.
+ *
+ *  RAM layout, from RAMSTART:
+ *    the Nucleus stack of processor 0 (the core file header page),
+ *    the kernel image,
+ *    the frames handed out here,
+ *    RAMTOP_STACK_PAGES frames: the stacks of test() and the delay daemon.
+ *
+ *      Written by Phuong and Oghap on Oct 2026
+ */
+
+#include "/usr/include/umps3/umps/libumps.h"
+
+#include "../h/types.h"
+#include "../h/const.h"
+
+#include "physMem.h"
+
+extern char _end[]; /* past the kernel image, set by the linker script */
+
+HIDDEN memaddr physNext; /* first frame not handed out */
+HIDDEN memaddr physTop;  /* past the last frame that may be handed out */
+
+/**********************************************************
+ *  initPhysMem()
+ *
+ *  Sets the range of frames to hand out, from the first
+ *  frame past the kernel image up to the stacks at the top
+ *  of the installed RAM.
+ *
+ *  Parameters:
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void initPhysMem() {
+	devregarea_t *busRegs = (devregarea_t *)RAMBASEADDR;
+
+	physNext = ((memaddr)_end + PAGESIZE - 1) & ~(PAGESIZE - 1);
+	physTop = busRegs->rambase + busRegs->ramsize - RAMTOP_STACK_PAGES * PAGESIZE;
+	if(physNext > physTop) {
+		PANIC();
+	}
+}
+
+/**********************************************************
+ *  phys_alloc()
+ *
+ *  Hands out consecutive frames. Running out of RAM at boot
+ *  is fatal.
+ *
+ *  Parameters:
+ *         int pages - frames wanted, may be 0
+ *
+ *  Returns:
+ *         memaddr - address of the first one
+ **********************************************************/
+memaddr phys_alloc(int pages) {
+	memaddr first = physNext;
+
+	if(pages > phys_pages_left()) {
+		PANIC();
+	}
+	physNext += pages * PAGESIZE;
+	return first;
+}
+
+/**********************************************************
+ *  phys_pages_left()
+ *
+ *  Parameters:
+ *
+ *  Returns:
+ *         int - frames that may still be handed out
+ **********************************************************/
+int phys_pages_left() {
+	return (physTop - physNext) / PAGESIZE;
+}
@@ -0,0 +1,17 @@
+/************************* PHYSMEM.H *****************************
+ *
+ *  The externals declaration file for PHYSMEM Module
+ *
+ *  Written by Phuong and Oghap on Oct 2026
+ */
+
+#ifndef PHYSMEM_H
+#define PHYSMEM_H
+
+#include "../h/types.h"
+
+void initPhysMem();
+memaddr phys_alloc(int pages);
+int phys_pages_left();
+
+#endif
@@ -0,0 +1,149 @@
+/*********************************PROF.C*******************************
+ *  Sampling Profiler Module
+ *
+ *  While profiling is on, every PLT interrupt that finds a process running
+ *  records its PC: in the histogram of its ASID for user mode code, in
+ *  histogram 0 for kernel mode code (the Support Level; the Nucleus runs
+ *  with interrupts disabled and is never sampled). Bucket b of a histogram
+ *  counts the PCs in [base + b * 64, base + (b + 1) * 64), base being KUSEG
+ *  for the U-procs and RAMSTART for the kernel.
+ *
+ *  With a sample period set, the scheduler splits each time slice into
+ *  periods on the PLT (prof_arm); an expiry inside the slice only takes a
+ *  sample and reloads the PLT, so sampling does not change the schedule.
+ *  The Support Level starts, stops and dumps the profile with PROFILE;
+ *  tools/profsym maps the buckets to functions.
+ *
+ *      Written by Phuong and Oghap on Oct 2026
+ */
+
+#include "/usr/include/umps3/umps/libumps.h"
+
+#include "../h/types.h"
+#include "../h/const.h"
+
+#include "smp.h"
+
+#include "prof.h"
+
+unsigned int profHist[MAXUPROC + 1][PROF_BUCKETS];
+unsigned int profOther[MAXUPROC + 1];
+HIDDEN int profOn = FALSE;     /* samples are taken */
+HIDDEN cpu_t profPeriod = 0;   /* sample period, 0 to sample on time slice ends only */
+
+/**********************************************************
+ *  prof_start()
+ *
+ *  Clears the histograms and starts sampling.
+ *
+ *  Parameters:
+ *         cpu_t period - sample period in us, 0 for PLT
+ *                        expiries only
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void prof_start(cpu_t period) {
+	int asid, bucket;
+
+	profOn = FALSE;
+	for(asid = 0; asid <= MAXUPROC; asid++) {
+		for(bucket = 0; bucket < PROF_BUCKETS; bucket++) {
+			profHist[asid][bucket] = 0;
+		}
+		profOther[asid] = 0;
+	}
+
+	if(period != 0 && period < PROF_MIN_PERIOD) {
+		period = PROF_MIN_PERIOD;
+	}
+	profPeriod = period;
+	profOn = TRUE;
+}
+
+/**********************************************************
+ *  prof_stop()
+ *
+ *  Stops sampling; the histograms are kept for the dump.
+ *
+ *  Parameters:
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void prof_stop() {
+	profOn = FALSE;
+	profPeriod = 0;
+}
+
+/**********************************************************
+ *  prof_base()
+ *
+ *  Address of bucket 0 of a histogram.
+ *
+ *  Parameters:
+ *         int asid - histogram, 0 for kernel mode
+ *
+ *  Returns:
+ *         memaddr - RAMSTART for the kernel, KUSEG otherwise
+ **********************************************************/
+memaddr prof_base(int asid) {
+	if(asid == 0) {
+		return RAMSTART;
+	}
+	return KUSEG;
+}
+
+/**********************************************************
+ *  prof_arm()
+ *
+ *  Returns the PLT value for a time slice about to start on
+ *  this processor: the whole slice, or one sample period
+ *  with the rest kept in c_sliceLeft.
+ *
+ *  Parameters:
+ *         cpu_t slice - time slice (or what is left of it)
+ *
+ *  Returns:
+ *         cpu_t - value to load on the PLT
+ **********************************************************/
+cpu_t prof_arm(cpu_t slice) {
+	cpu_t period = profPeriod;
+
+	if(period == 0 || slice <= period) {
+		cpus[getPRID()].c_sliceLeft = 0;
+		return slice;
+	}
+	cpus[getPRID()].c_sliceLeft = slice - period;
+	return period;
+}
+
+/**********************************************************
+ *  prof_sample()
+ *
+ *  Records the PC of an interrupted process, if profiling.
+ *
+ *  Parameters:
+ *         state_PTR s - its saved processor state
+ *         int asid - its ASID, 0 if none
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void prof_sample(state_PTR s, int asid) {
+	unsigned int bucket;
+
+	if(profOn == FALSE) {
+		return;
+	}
+	if((s->s_status & KUPBITON) == 0 || asid < 0 || asid > MAXUPROC) {
+		asid = 0;
+	}
+
+	bucket = (s->s_pc - prof_base(asid)) >> PROF_SHIFT;
+	if(bucket < PROF_BUCKETS) {
+		profHist[asid][bucket]++;
+	} else {
+		profOther[asid]++;
+	}
+}
@@ -0,0 +1,22 @@
+/************************* PROF.H *****************************
+ *
+ *  The externals declaration file for PROF Module
+ *
+ *  Written by Phuong and Oghap on Oct 2026
+ */
+
+#ifndef PROF_H
+#define PROF_H
+
+#include "../h/pcb.h"
+
+extern unsigned int profHist[MAXUPROC + 1][PROF_BUCKETS]; /* PC histograms, index 0 for kernel mode */
+extern unsigned int profOther[MAXUPROC + 1];              /* samples outside the histogram range */
+
+void prof_start(cpu_t period);
+void prof_stop();
+memaddr prof_base(int asid);
+cpu_t prof_arm(cpu_t slice);
+void prof_sample(state_PTR s, int asid);
+
+#endif
@@ -8,8 +8,39 @@
  *  and gives it control.
  *
  *  The scheduler uses a queue to manage ready processes. When a process is selected to
- *  run, its state is loaded using `LDST()`, and the processor timer is set to 5
- *  milliseconds to ensure proper execution.
+ *  run, its state is loaded using `LDST()`, and the processor timer is set to
+ *  its quantum to ensure proper execution. The quantum starts at QUANTUM (5
+ *  milliseconds) and adapts: it doubles, up to QUANTUM_MAX, each time the process
+ *  uses it up, and halves, down to QUANTUM_MIN, each time the process blocks
+ *  having used less than half of it. CPU-bound processes are switched less often,
+ *  and the ones that block early keep a short slice. Every dispatch is counted
+ *  in p_switches.
+ *
+ *  This module also keeps the CPU time accounting. acctStart holds the TOD of the
+ *  last charge; the elapsed time is charged to the running process on exception
+ *  entry and when a syscall returns, and to the kernel when an interrupt is done
+ *  or a process is dispatched. Time waiting with no process is idle time.
+ *
+ *  Each processor has its own ready queue: a process made ready goes on the queue
+ *  of the processor that readied it.
+ *
+ *  The round-robin class is shared out by stride scheduling: every process holds
+ *  tickets (SETTICKETS) and its pass grows by the CPU time it is charged divided by
+ *  its tickets, so the charge made for accounting (and GETCPUTIME) also drives the
+ *  shares. The ready process with the lowest pass runs next, from any queue, this
+ *  processor's first on a tie. A process made ready is brought up to the pass of
+ *  the last dispatch when it is new or unblocked, so time spent blocked is not
+ *  banked as credit.
+ *
+ *  Processes of the EDF class (registered with SETEDF) share one queue, edfQ, and
+ *  go before the round-robin ones: the scheduler runs the released job with the
+ *  earliest deadline. A job gets its budget of CPU time per period, enforced with
+ *  the PLT; once the budget is used up the process waits in edfQ for its next
+ *  release. The PLT also fires at the next release of a waiting EDF process, so a
+ *  new job preempts within at most one time slice. A job ends when the process
+ *  blocks or uses its budget up; one still unfinished past its deadline counts as
+ *  a deadline miss. Admission keeps the total density (budget / deadline) within
+ *  one processor.
  *
  *  Modified by Phuong and Oghap on Feb 2025
  */
@@ -22,9 +53,448 @@
 #include "../h/const.h"
 
 #include "initial.h"
+#include "smp.h"
+#include "histogram.h"
+#include "trace.h"
+#include "prof.h"
 
 #include "scheduler.h"
 
+HIDDEN pcb_PTR edfQ = NULL; /* tail ptr to the ready EDF processes, released or waiting for their release */
+HIDDEN int edfDensity = 0;  /* total density of the admitted EDF processes */
+HIDDEN unsigned int stridePass = 0; /* global pass: the lowest pass of the ready set, at the last round-robin dispatch */
+
+/**********************************************************
+ *  deep_copy_state_t()
+ *
+ *  Copies a processor state as a block of words, five per
+ *  iteration, instead of field by field.
+ *
+ *  Parameters:
+ *         state_PTR dest - Pointer to the destination state
+ *         state_PTR src  - Pointer to the source state
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void deep_copy_state_t(state_PTR dest, state_PTR src) {
+	unsigned int *d = (unsigned int *)dest;
+	unsigned int *s = (unsigned int *)src;
+	unsigned int *end = s + STATEWORDS;
+	while(s < end) {
+		d[0] = s[0];
+		d[1] = s[1];
+		d[2] = s[2];
+		d[3] = s[3];
+		d[4] = s[4];
+		d += 5;
+		s += 5;
+	}
+}
+
+/**********************************************************
+ *  make_ready()
+ *
+ *  Puts a process on the ready queue of this processor, or
+ *  on edfQ if it is of the EDF class, and wakes an idle
+ *  processor up to take it. An EDF process woken after the
+ *  deadline of its job gets a new one, relative to now.
+ *
+ *  Parameters:
+ *         pcb_PTR p - process that became ready
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void make_ready(pcb_PTR p) {
+	cpu_t now;
+
+	if(p->p_period != 0) {
+		/* with its old deadline it would run ahead of every job with a valid one */
+		if(p->p_state != PROC_RUNNING) {
+			STCK(now);
+			if(now > p->p_deadline) {
+				p->p_deadline = now + p->p_relDeadline;
+			}
+		}
+		insertProcQ(&edfQ, p);
+	} else {
+		/* a new or unblocked process starts from the current pass, a preempted one keeps its own */
+		if(p->p_state != PROC_RUNNING && (int)(p->p_pass - stridePass) < 0) {
+			p->p_pass = stridePass;
+		}
+		insertProcQ(&(cpus[getPRID()].c_readyQ), p);
+	}
+	p->p_state = PROC_READY;
+	smp_wakeup_idle();
+}
+
+/**********************************************************
+ *  out_ready()
+ *
+ *  Removes a process from whichever ready queue holds it,
+ *  which the pcb records.
+ *
+ *  Parameters:
+ *         pcb_PTR p - process to remove
+ *
+ *  Returns:
+ *         pcb_PTR - p, or NULL if it was not ready
+ **********************************************************/
+pcb_PTR out_ready(pcb_PTR p) {
+	if(p->p_state != PROC_READY) {
+		return NULL;
+	}
+	return outProcQ(p->p_queue, p);
+}
+
+/**********************************************************
+ *  helper_take_ready()
+ *
+ *  Removes the round-robin process with the lowest stride
+ *  pass from the ready queues, starting with this processor's
+ *  so that it wins a tie.
+ *
+ *  Parameters:
+ *
+ *  Returns:
+ *         pcb_PTR - process to run, NULL if none is ready
+ **********************************************************/
+HIDDEN pcb_PTR helper_take_ready() {
+	int self = getPRID();
+	pcb_PTR best = NULL;
+	pcb_PTR tail, p;
+	int i;
+
+	for(i = 0; i < NCPU; i++) {
+		tail = cpus[(self + i) % NCPU].c_readyQ;
+		p = headProcQ(tail);
+		while(p != NULL) {
+			if(best == NULL || (int)(p->p_pass - best->p_pass) < 0) {
+				best = p;
+			}
+			p = (p == tail) ? NULL : p->p_next;
+		}
+	}
+
+	if(best != NULL) {
+		outProcQ(best->p_queue, best);
+	}
+	return best;
+}
+
+/**********************************************************
+ *  helper_stride_charge()
+ *
+ *  Advances the stride pass of a process by the CPU time it
+ *  used divided by its tickets, keeping the remainder so that
+ *  short charges are not lost.
+ *
+ *  Parameters:
+ *         pcb_PTR p - round-robin process
+ *         cpu_t used - CPU time to charge
+ *
+ *  Returns:
+ *
+ **********************************************************/
+HIDDEN void helper_stride_charge(pcb_PTR p, cpu_t used) {
+	int units = used * STRIDE_SCALE + p->p_passRem;
+	p->p_pass += units / p->p_tickets;
+	p->p_passRem = units % p->p_tickets;
+}
+
+/**********************************************************
+ *  quantum_adapt()
+ *
+ *  Adapts the quantum of a round-robin process when it leaves
+ *  the processor it ran on: doubled when the PLT expired at
+ *  the end of a whole quantum, not of a slice cut short for
+ *  an EDF release, and halved when it blocks with more than
+ *  half of it left.
+ *  While profiling, what is left is the PLT plus the rest of
+ *  the slice kept in c_sliceLeft.
+ *
+ *  Parameters:
+ *         pcb_PTR p - process leaving this processor
+ *         int expired - TRUE on PLT expiry, FALSE when blocking
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void quantum_adapt(pcb_PTR p, int expired) {
+	if(p->p_period != 0) {
+		return;
+	}
+	if(expired == TRUE) {
+		if(cpus[getPRID()].c_fullSlice == FALSE) {
+			return;
+		}
+		p->p_quantum *= 2;
+		if(p->p_quantum > QUANTUM_MAX) {
+			p->p_quantum = QUANTUM_MAX;
+		}
+	} else if((int)(getTIMER() + cpus[getPRID()].c_sliceLeft) > p->p_quantum / 2) {
+		p->p_quantum /= 2;
+		if(p->p_quantum < QUANTUM_MIN) {
+			p->p_quantum = QUANTUM_MIN;
+		}
+	}
+}
+
+/**********************************************************
+ *  stride_set_tickets()
+ *
+ *  Sets the tickets of a process, which weigh its share of
+ *  the round-robin class from its next charge on.
+ *
+ *  Parameters:
+ *         pcb_PTR p - process
+ *         int tickets - 1 to STRIDE_MAX_TICKETS
+ *
+ *  Returns:
+ *         int - previous tickets, -1 if out of range
+ **********************************************************/
+int stride_set_tickets(pcb_PTR p, int tickets) {
+	int old = p->p_tickets;
+	if(tickets < 1 || tickets > STRIDE_MAX_TICKETS) {
+		return -1;
+	}
+	p->p_tickets = tickets;
+	p->p_passRem = 0;
+	return old;
+}
+
+/**********************************************************
+ *  helper_edf_density()
+ *
+ *  Density of an EDF process, rounded up so that admission
+ *  stays on the safe side.
+ *
+ *  Parameters:
+ *         pcb_PTR p - process
+ *
+ *  Returns:
+ *         int - budget / deadline in per-mille, 0 if not EDF
+ **********************************************************/
+HIDDEN int helper_edf_density(pcb_PTR p) {
+	if(p->p_period == 0) {
+		return 0;
+	}
+	return (p->p_budget * EDF_DENSITY_ONE + p->p_relDeadline - 1) / p->p_relDeadline;
+}
+
+/**********************************************************
+ *  helper_edf_update()
+ *
+ *  Brings the job of an EDF process up to date: closes it
+ *  if its budget is used up, counts a deadline miss if it is
+ *  still open past its deadline, and releases the next job
+ *  once its period starts, skipping the periods that went by.
+ *
+ *  Parameters:
+ *         pcb_PTR p - ready EDF process
+ *         cpu_t now - current TOD
+ *
+ *  Returns:
+ *
+ **********************************************************/
+HIDDEN void helper_edf_update(pcb_PTR p, cpu_t now) {
+	if(p->p_budgetLeft <= 0) {
+		p->p_jobOpen = FALSE;
+	}
+	if(p->p_jobOpen == TRUE && now > p->p_deadline) {
+		p->p_misses++;
+		p->p_jobOpen = FALSE;
+	}
+	if(now >= p->p_release) {
+		while(p->p_release <= now) {
+			p->p_release += p->p_period;
+		}
+		p->p_deadline = p->p_release - p->p_period + p->p_relDeadline;
+		p->p_budgetLeft = p->p_budget;
+		p->p_jobOpen = TRUE;
+	}
+}
+
+/**********************************************************
+ *  helper_take_edf()
+ *
+ *  Removes from edfQ the process whose released job has the
+ *  earliest deadline and budget left. Lowers the time slice
+ *  to the next release of the processes left in edfQ, so the
+ *  scheduler runs again when a new job arrives.
+ *
+ *  Parameters:
+ *         cpu_t now - current TOD
+ *         cpu_t *slice - time slice, lowered to the next release
+ *
+ *  Returns:
+ *         pcb_PTR - process to run, NULL if no job is released
+ **********************************************************/
+HIDDEN pcb_PTR helper_take_edf(cpu_t now, cpu_t *slice) {
+	pcb_PTR best = NULL;
+	pcb_PTR p = headProcQ(edfQ);
+
+	if(p == NULL) {
+		return NULL;
+	}
+
+	do {
+		helper_edf_update(p, now);
+		if(p->p_budgetLeft > 0 && (best == NULL || p->p_deadline < best->p_deadline)) {
+			best = p;
+		}
+		p = p->p_next;
+	} while(p != headProcQ(edfQ));
+
+	if(best != NULL) {
+		outProcQ(&edfQ, best);
+	}
+
+	p = headProcQ(edfQ);
+	while(p != NULL) {
+		if(p->p_release - now < *slice) {
+			*slice = p->p_release - now;
+		}
+		p = (p == edfQ) ? NULL : p->p_next;
+	}
+	return best;
+}
+
+/**********************************************************
+ *  edf_admit()
+ *
+ *  Admission control of the EDF class: the process joins it
+ *  (or changes its parameters) only if the total density
+ *  stays within EDF_DENSITY_MAX. Its first job is released
+ *  at once.
+ *
+ *  Parameters:
+ *         pcb_PTR p - process, the Current Process
+ *         cpu_t period - release period in us
+ *         cpu_t budget - CPU time per period in us
+ *         cpu_t deadline - relative deadline in us, 0 for the period
+ *
+ *  Returns:
+ *         int - 0 if admitted, -1 if rejected
+ **********************************************************/
+int edf_admit(pcb_PTR p, cpu_t period, cpu_t budget, cpu_t deadline) {
+	int density;
+	cpu_t now;
+
+	if(deadline == 0) {
+		deadline = period;
+	}
+	if(budget < EDF_MIN_BUDGET || deadline < budget || period < deadline || period > EDF_MAX_PERIOD) {
+		return -1;
+	}
+
+	density = (budget * EDF_DENSITY_ONE + deadline - 1) / deadline;
+	if(edfDensity - helper_edf_density(p) + density > EDF_DENSITY_MAX) {
+		return -1;
+	}
+
+	edf_leave(p);
+	edfDensity += density;
+
+	STCK(now);
+	p->p_period = period;
+	p->p_budget = budget;
+	p->p_relDeadline = deadline;
+	p->p_release = now + period;
+	p->p_deadline = now + deadline;
+	p->p_budgetLeft = budget;
+	p->p_jobOpen = TRUE;
+	return 0;
+}
+
+/**********************************************************
+ *  edf_leave()
+ *
+ *  Takes a process out of the EDF class, back to round-robin,
+ *  and gives its density back. The process must not be on
+ *  a ready queue.
+ *
+ *  Parameters:
+ *         pcb_PTR p - process
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void edf_leave(pcb_PTR p) {
+	edfDensity -= helper_edf_density(p);
+	p->p_period = 0;
+}
+
+/**********************************************************
+ *  helper_running_count()
+ *
+ *  Counts the processors that are running a process.
+ *
+ *  Parameters:
+ *
+ *  Returns:
+ *         int - number of busy processors
+ **********************************************************/
+HIDDEN int helper_running_count() {
+	int i;
+	int running = 0;
+	for(i = 0; i < NCPU; i++) {
+		if(cpus[i].c_currentP != NULL) {
+			running++;
+		}
+	}
+	return running;
+}
+
+/**********************************************************
+ *  acct_charge_process()
+ *
+ *  Charges the time elapsed since the last charge to the
+ *  Current Process, and to its EDF budget or stride pass,
+ *  or to idle time if there is none.
+ *
+ *  Parameters:
+ *
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void acct_charge_process() {
+	cpu_t now;
+	STCK(now);
+	if(currentP != NULL) {
+		currentP->p_time += now - acctStart;
+		if(currentP->p_period != 0) {
+			currentP->p_budgetLeft -= now - acctStart;
+		} else {
+			helper_stride_charge(currentP, now - acctStart);
+		}
+	} else {
+		idleTime += now - acctStart;
+	}
+	acctStart = now;
+}
+
+/**********************************************************
+ *  acct_charge_kernel()
+ *
+ *  Charges the time elapsed since the last charge to the
+ *  kernel (interrupt handling and scheduling).
+ *
+ *  Parameters:
+ *
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void acct_charge_kernel() {
+	cpu_t now;
+	STCK(now);
+	kernelTime += now - acctStart;
+	acctStart = now;
+}
+
 /**********************************************************
  *  scheduler()
  *
@@ -33,9 +503,12 @@
  *  determines the appropriate system action based on the process
  *  count and soft-block count.
  *
- *  The scheduler implements a round-robin scheduling method and
- *  sets each process to get an execution time by setting
- *  the processor timer to 5 milliseconds.
+ *  The scheduler runs the released EDF job with the earliest
+ *  deadline if any, otherwise the round-robin process with the
+ *  lowest stride pass, and sets each process to get an execution
+ *  time by setting the processor timer to its own quantum. It is called
+ *  holding the Nucleus lock and releases it when leaving the
+ *  Nucleus.
  *
  *  Parameters:
  *
@@ -44,17 +517,42 @@
  *
  **********************************************************/
 void scheduler() {
-	currentP = removeProcQ(&readyQ); /* if the ready Q is empty */
+	cpu_t now;
+	cpu_t slice = QUANTUM_MAX;
+
+	STCK(now);
+	currentP = helper_take_edf(now, &slice);
 	if(currentP == NULL) {
+		currentP = helper_take_ready();
+	}
+	if(currentP == NULL) { /* if every ready Q is empty */
 		/* if the Process Count is zero */
 		if(process_count == 0) {
 			HALT();
 
-		} else if(softBlock_count > 0) {
-			/* if Process Count > 0 and the Soft-block Count > 0 */
+		} else if(softBlock_count > 0 || helper_running_count() > 0 || edfQ != NULL) {
+			/* if Process Count > 0 and the Soft-block Count > 0, another processor may ready a process,
+			   or an EDF process waits for its release */
 
-			/* get status, enable interrupt on current enable bit, disable PLT, enable Interrupt Mask */
-			setSTATUS(0x0000ff01);
+			/* from here on the processor is idle, and the first to take device interrupts */
+			cpus[getPRID()].c_idle = TRUE;
+			*((memaddr *)CPUCTL_TPR) = IDLE_PRIORITY;
+#ifdef PANDOS_DEBUG
+			trace_record(TRACE_SWITCH, 0, 0, 0, 0);
+#endif
+			acct_charge_kernel();
+
+			cpus[getPRID()].c_sliceLeft = 0;
+			if(edfQ != NULL) {
+				/* wake up on the PLT at the next release */
+				setTIMER(slice);
+				kernel_unlock();
+				setSTATUS(0x0000ff01 | TEBITON);
+			} else {
+				kernel_unlock();
+				/* get status, enable interrupt on current enable bit, disable PLT, enable Interrupt Mask */
+				setSTATUS(0x0000ff01);
+			}
 			WAIT();
 		} else {
 			/* if ProcessCount > 0 and softBlock_count = 0 */
@@ -62,9 +560,43 @@ void scheduler() {
 		}
 	}
 
-	/*Load 5 milisec on the PLT*/
-	setTIMER(5000);
+	currentP->p_state = PROC_RUNNING;
+
+	/* cache the page table base for the TLB-Refill handler */
+	if(currentP->p_supportStruct != NULL) {
+		currentPgDir = currentP->p_supportStruct->sup_pgDir;
+	} else {
+		currentPgDir = NULL;
+	}
+
+	/* Load the time slice on the PLT: an EDF job gets no more than its budget left,
+	   a round-robin process its own quantum */
+	if(currentP->p_period != 0) {
+		if(currentP->p_budgetLeft < slice) {
+			slice = currentP->p_budgetLeft;
+		}
+	} else {
+		if(currentP->p_quantum < slice) {
+			slice = currentP->p_quantum;
+		}
+		/* a slice cut short for an EDF release says nothing about the process */
+		cpus[getPRID()].c_fullSlice = (slice == currentP->p_quantum);
+		/* helper_take_ready() took the lowest pass of the ready set */
+		stridePass = currentP->p_pass;
+	}
+	currentP->p_switches++;
+#ifdef PANDOS_DEBUG
+	trace_record(TRACE_SWITCH, hist_asid(currentP), (memaddr)currentP, slice, 0);
+#endif
+	/* while profiling the slice is loaded one sample period at a time */
+	setTIMER(prof_arm(slice));
+	*((memaddr *)CPUCTL_TPR) = BUSY_PRIORITY;
+
+	/* dispatch: the process is charged from now on */
+	acct_charge_kernel();
 
-	/* pass in the address of current process processor state */
-	LDST(&(currentP->p_s));
+	/* load from this processor's copy: once the lock is released another processor may terminate the process */
+	deep_copy_state_t(EXCSTATE, &(currentP->p_s));
+	kernel_unlock();
+	LDST(EXCSTATE);
 }
\ No newline at end of file
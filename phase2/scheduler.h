@@ -9,13 +9,24 @@
 #define SCHEDULER_H
 
 #include "../h/pcb.h"
+#include "smp.h"
 
 extern int process_count;                                     /* Number of started processes */
 extern int softBlock_count;                                   /* Number of started that are in blocked */
-extern pcb_PTR readyQ;                                        /* Tail ptr to a queue of pcbs that are ready */
-extern pcb_PTR currentP;                                      /* Current Process */
+extern cpu_t kernelTime;                                      /* CPU time spent handling interrupts and scheduling */
+extern cpu_t idleTime;                                        /* time spent waiting for an interrupt */
 extern int device_sem[DEVINTNUM * DEVPERINT + DEVPERINT + 1]; /* Device Semaphores 49 semaphores in an array */
+extern int device_status[DEVINTNUM * DEVPERINT + DEVPERINT + 1]; /* status of an interrupt that came before its SYS5 */
 
 void scheduler();
+void deep_copy_state_t(state_PTR dest, state_PTR src);
+void make_ready(pcb_PTR p);
+pcb_PTR out_ready(pcb_PTR p);
+void acct_charge_process();
+void acct_charge_kernel();
+int edf_admit(pcb_PTR p, cpu_t period, cpu_t budget, cpu_t deadline);
+void edf_leave(pcb_PTR p);
+int stride_set_tickets(pcb_PTR p, int tickets);
+void quantum_adapt(pcb_PTR p, int expired);
 
 #endif
\ No newline at end of file
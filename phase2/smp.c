@@ -0,0 +1,261 @@
+/*********************************SMP.C*******************************
+ *
+ *  Symmetric Multiprocessing Module
+ *
+ *  Every processor runs the Nucleus on its own stack, with its own
+ *  Current Process, ready queue and CPU time accounting (cpus[]).
+ *  The shared Nucleus data (ASL, pcb pool, device semaphores,
+ *  process and soft-block counts) is protected by kernelLock,
+ *  taken on exception entry and released just before control
+ *  leaves the Nucleus (LDST, LDCXT or WAIT).
+ *
+ *  Processors talk through inter-processor interrupts (IPIs):
+ *  - IPI_WAKEUP tells an idle processor that a process became
+ *    ready, so it leaves WAIT and steals it;
+ *  - IPI_TLBFLUSH asks a processor to clear its TLB, used by the
+ *    pager when a frame changes hands.
+ *
+ *  Device and Interval Timer interrupts are routed dynamically to
+ *  the processor with the lowest Task Priority: idle processors
+ *  lower theirs so they take interrupts off the busy ones.
+ *
+ */
+
+#include "/usr/include/umps3/umps/libumps.h"
+
+#include "../h/pcb.h"
+#include "../h/types.h"
+#include "../h/const.h"
+
+#include "exceptions.h"
+#include "scheduler.h"
+#include "initial.h"
+
+#include "smp.h"
+#include "physMem.h"
+
+cpuState_t cpus[NCPU];                       /* per-processor Nucleus state */
+volatile unsigned int kernelLock;            /* Nucleus lock */
+HIDDEN volatile unsigned int tlbFlushPending; /* processors that still have to clear their TLB */
+HIDDEN state_t cpuStartState[NCPU];          /* initial state of the secondary processors */
+
+/**********************************************************
+ *  kernel_lock()
+ *
+ *  Spins until the Nucleus lock is acquired. Must be called
+ *  with interrupts disabled.
+ *
+ *  Parameters:
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void kernel_lock() {
+	while(CAS((unsigned int *)&kernelLock, 0, 1) == FALSE) {
+		;
+	}
+}
+
+/**********************************************************
+ *  kernel_unlock()
+ *
+ *  Releases the Nucleus lock.
+ *
+ *  Parameters:
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void kernel_unlock() {
+	kernelLock = 0;
+}
+
+/**********************************************************
+ *  ipi_send()
+ *
+ *  Sends an inter-processor interrupt carrying a message to
+ *  a set of processors.
+ *
+ *  Parameters:
+ *         unsigned int recipients - bit i set for processor i
+ *         unsigned int message - IPI_WAKEUP or IPI_TLBFLUSH
+ *
+ *  Returns:
+ *
+ **********************************************************/
+HIDDEN void ipi_send(unsigned int recipients, unsigned int message) {
+	*((memaddr *)CPUCTL_OUTBOX) = (recipients << IPI_RECIP_SHIFT) | message;
+}
+
+/**********************************************************
+ *  cpu_start()
+ *
+ *  First code run by a secondary processor: joins the
+ *  Nucleus and looks for a process to run.
+ *
+ *  Parameters:
+ *
+ *  Returns:
+ *
+ **********************************************************/
+HIDDEN void cpu_start() {
+	kernel_lock();
+	STCK(acctStart);
+	scheduler();
+}
+
+/**********************************************************
+ *  smp_start_cpus()
+ *
+ *  Routes the interrupts to every processor, populates the
+ *  Pass Up Vectors of the secondary processors, each with
+ *  its own Nucleus stack page from phys_alloc(), and starts
+ *  them. Called by
+ *  processor 0 holding the Nucleus lock.
+ *
+ *  Parameters:
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void smp_start_cpus() {
+	int i;
+	memaddr stackArea, stackTop;
+	passupvector_t *passup;
+
+	for(i = 0; i < IRT_NUM_ENTRY; i++) {
+		*((memaddr *)(IRT_START + i * WORDLEN)) = IRT_RP_BIT_ON | ((1 << NCPU) - 1);
+	}
+
+	/* one Nucleus stack page per processor but 0 */
+	stackArea = phys_alloc(NCPU - 1);
+	for(i = 1; i < NCPU; i++) {
+		stackTop = stackArea + i * PAGESIZE;
+
+		passup = (passupvector_t *)(PASSUPVECTOR + i * PASSUPVECTOR_SIZE);
+		passup->tlb_refll_handler = (memaddr)uTLB_RefillHandler;
+		passup->tlb_refll_stackPtr = stackTop;
+		passup->exception_handler = (memaddr)exception_handler;
+		passup->exception_stackPtr = stackTop;
+
+		/* kernel mode, interrupts and PLT disabled until the first dispatch */
+		cpuStartState[i].s_status = ALLOFF;
+		cpuStartState[i].s_pc = (memaddr)cpu_start;
+		cpuStartState[i].s_t9 = (memaddr)cpu_start;
+		cpuStartState[i].s_sp = stackTop;
+		cpuStartState[i].s_entryHI = 0;
+		cpuStartState[i].s_cause = 0;
+		INITCPU(i, &cpuStartState[i]);
+	}
+}
+
+/**********************************************************
+ *  smp_wakeup_idle()
+ *
+ *  Sends IPI_WAKEUP to one idle processor, if any, after a
+ *  process was made ready. Called holding the Nucleus lock.
+ *
+ *  Parameters:
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void smp_wakeup_idle() {
+	int i;
+	int self = getPRID();
+	for(i = 0; i < NCPU; i++) {
+		if(i != self && cpus[i].c_idle == TRUE) {
+			/* only one wakeup per idle period */
+			cpus[i].c_idle = FALSE;
+			ipi_send(1 << i, IPI_WAKEUP);
+			return;
+		}
+	}
+}
+
+/**********************************************************
+ *  smp_stop_remote()
+ *
+ *  If the given process is running on another processor,
+ *  takes it off that processor: the processor finds no
+ *  Current Process on its next Nucleus entry, which the IPI
+ *  forces, and calls the scheduler. Called holding the
+ *  Nucleus lock, before the pcb is freed.
+ *
+ *  Parameters:
+ *         pcb_PTR p - process being terminated
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void smp_stop_remote(pcb_PTR p) {
+	int i;
+	int self = getPRID();
+	for(i = 0; i < NCPU; i++) {
+		if(i != self && cpus[i].c_currentP == p) {
+			cpus[i].c_currentP = NULL;
+			ipi_send(1 << i, IPI_WAKEUP);
+		}
+	}
+}
+
+/**********************************************************
+ *  ipi_receive()
+ *
+ *  Handles an inter-processor interrupt: acknowledges it and
+ *  clears the TLB if a flush was requested. A wakeup needs no
+ *  further action, the interrupt return path calls the
+ *  scheduler when there is no Current Process.
+ *
+ *  Parameters:
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void ipi_receive() {
+	unsigned int self = 1 << getPRID();
+	unsigned int pending;
+
+	/* acknowledge the message */
+	*((memaddr *)CPUCTL_INBOX) = ALLOFF;
+
+	if((tlbFlushPending & self) != 0) {
+		TLBCLR();
+		do {
+			pending = tlbFlushPending;
+		} while(CAS((unsigned int *)&tlbFlushPending, pending, pending & ~self) == FALSE);
+	}
+}
+
+/**********************************************************
+ *  tlb_shootdown()
+ *
+ *  Clears the TLB of every other processor and waits until
+ *  all of them did, so that no stale translation of a frame
+ *  survives its reuse. Called by the support level holding
+ *  the swap pool semaphore, hence by one processor at a time,
+ *  and without the Nucleus lock.
+ *
+ *  Parameters:
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void tlb_shootdown() {
+	unsigned int others = ((1 << NCPU) - 1) & ~(1 << getPRID());
+	unsigned int pending;
+
+	if(others == 0) {
+		return;
+	}
+
+	do {
+		pending = tlbFlushPending;
+	} while(CAS((unsigned int *)&tlbFlushPending, pending, pending | others) == FALSE);
+
+	ipi_send(others, IPI_TLBFLUSH);
+
+	while((tlbFlushPending & others) != 0) {
+		;
+	}
+}
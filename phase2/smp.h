@@ -0,0 +1,30 @@
+/**************************** SMP.H ********************************
+ *
+ *  The externals declaration file for the SMP Module
+ *
+ *  currentP, currentPgDir and acctStart name the entry of the
+ *  processor executing the code in the per-processor state.
+ *
+ */
+
+#ifndef SMP_H
+#define SMP_H
+
+#include "../h/pcb.h"
+
+extern cpuState_t cpus[NCPU];            /* per-processor Nucleus state */
+extern volatile unsigned int kernelLock; /* Nucleus lock: ASL, pcb pool, ready queues, counters */
+
+#define currentP (cpus[getPRID()].c_currentP)       /* Current Process */
+#define currentPgDir (cpus[getPRID()].c_pgDir)      /* First-level page table of the Current Process */
+#define acctStart (cpus[getPRID()].c_acctStart)     /* TOD of the last CPU time charge */
+
+void kernel_lock();
+void kernel_unlock();
+void smp_start_cpus();
+void smp_wakeup_idle();
+void smp_stop_remote(pcb_PTR p);
+void ipi_receive();
+void tlb_shootdown();
+
+#endif
@@ -0,0 +1,64 @@
+/*********************************TRACE.C*******************************
+ *  Event Trace Module
+ *
+ *  This module keeps the last TRACE_ENTRIES events of the Nucleus and the
+ *  pager in a ring buffer, each stamped with the TOD and the processor:
+ *  dispatches, syscalls, interrupts, page faults, page outs, and device
+ *  commands and completions. Event number n goes in slot
+ *  n % TRACE_ENTRIES, so the buffer always holds the most recent ones.
+ *
+ *  Events are recorded with and without the Nucleus lock (the pager runs
+ *  at the Support Level), so a slot is claimed by advancing traceNext
+ *  with CAS, and the event is stamped with its sequence number once
+ *  filled in. The Support Level drains the buffer to a printer with
+ *  TRACEDUMP; tools/trace2json turns the dump into a Chrome trace. The
+ *  dispatches, syscalls and interrupts are on the hot paths and only
+ *  recorded with -DPANDOS_DEBUG; the page faults, page outs and device
+ *  commands and completions are always recorded.
+ *
+ *      Written by Phuong and Oghap on Oct 2026
+ */
+
+#include "/usr/include/umps3/umps/libumps.h"
+
+#include "../h/types.h"
+#include "../h/const.h"
+
+#include "trace.h"
+
+traceEvent_t traceBuf[TRACE_ENTRIES];
+volatile unsigned int traceNext;
+
+/**********************************************************
+ *  trace_record()
+ *
+ *  Appends one event to the ring buffer, overwriting the
+ *  oldest one when it is full.
+ *
+ *  Parameters:
+ *         int kind - TRACE_*
+ *         int asid - ASID of the process concerned, 0 if none
+ *         unsigned int arg0, arg1, arg2 - depend on the kind
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void trace_record(int kind, int asid, unsigned int arg0, unsigned int arg1, unsigned int arg2) {
+	unsigned int seq;
+	traceEvent_t *event;
+
+	do {
+		seq = traceNext;
+	} while(CAS((unsigned int *)&traceNext, seq, seq + 1) == FALSE);
+
+	event = &(traceBuf[seq & (TRACE_ENTRIES - 1)]);
+	STCK(event->e_tod);
+	event->e_kind = kind;
+	event->e_cpu = getPRID();
+	event->e_asid = asid;
+	event->e_arg[0] = arg0;
+	event->e_arg[1] = arg1;
+	event->e_arg[2] = arg2;
+	/* last: a reader that sees it knows the fields above are this event's */
+	event->e_seq = seq + 1;
+}
@@ -0,0 +1,18 @@
+/************************* TRACE.H *****************************
+ *
+ *  The externals declaration file for TRACE Module
+ *
+ *  Written by Phuong and Oghap on Oct 2026
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "../h/pcb.h"
+
+extern traceEvent_t traceBuf[TRACE_ENTRIES]; /* event ring buffer */
+extern volatile unsigned int traceNext;      /* sequence number of the next event */
+
+void trace_record(int kind, int asid, unsigned int arg0, unsigned int arg1, unsigned int arg2);
+
+#endif
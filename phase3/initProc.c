@@ -8,12 +8,16 @@
  *  8 user processes, enabling virtual memory support and TLB handling.
  *
  *  The user process setup includes:
- *  - Initializing each U-proc’s private page table with proper VPN,
- *    ASID, and valid/dirty bits.
+ *  - Initializing each U-proc’s private page table; its second-level
+ *    tables are allocated on demand by the pager.
  *  - Assigning stack pointers and exception handlers for both TLB and
  *    general exceptions.
  *  - Creating the initial state for each process and invoking SYSCALL
  *    to create the PCB and insert it into the Ready Queue.
+ *  - Staging the U-proc images on the swap disk. Identical pages, found
+ *    by hash and then compared, are staged once: imageSect gives the
+ *    sector every image page is read from, and the pager shares one
+ *    frame among the U-procs using the same sector.
  *
  *      Modified by Phuong and Oghap on March 2025
  */
@@ -22,9 +26,17 @@
 #include "vmSupport.h"
 #include "sysSupport.h"
 #include "../phase5/delayDaemon.h"
+#include "msgSupport.h"
+#include "loadSupport.h"
+#include "../phase2/physMem.h"
 
 int masterSemaphore = 0;
 int mutex[DEVINTNUM * DEVPERINT + DEVPERINT];
+int imageSect[MAXUPROC][UPROC_IMAGE_PAGES]; /* swap disk sector holding each image page */
+memaddr diskDmaBuf;                         /* DMA buffer of each disk, one page per device */
+memaddr flashDmaBuf;                        /* DMA buffer of each flash device, one page per device */
+
+HIDDEN unsigned int imageHash[MAXUPROC][UPROC_IMAGE_PAGES];
 
 void debugSBS(){
 
@@ -34,8 +46,9 @@ void debugSBS(){
  *  init_Uproc_pgTable
  *
  *  Initializes the page table for a user-level process.
- *  Sets EntryHi with VPN and ASID, and EntryLo with initial
- *  D, V, and G bit settings. Stack page is set separately.
+ *  Only the first-level table is cleared here: second-level
+ *  tables are built by the pager, with VPN, ASID and initial
+ *  D, V, and G bit settings, the first time a range is touched.
  *
  *  Parameters:
  *         support_t *currentSupport – pointer to U-proc's support structure
@@ -44,23 +57,19 @@ void debugSBS(){
  *
  **********************************************************/
 void init_Uproc_pgTable(support_t *currentSupport) {
-	/* To initialize a Page Table one needs to set the VPN, ASID, V, and D bit fields for each Page Table entry*/
 	int i;
-	for(i = 0; i < PAGE_TABLE_SIZE; i++) {
-		/* ASID field, for any given Page Table, will all be set to the U-proc’s unique ID*/
-		currentSupport->sup_privatePgTbl[i].EntryHi = KUSEG + (i * PAGESIZE) + (currentSupport->sup_asid << ASID_SHIFT);
-		currentSupport->sup_privatePgTbl[i].EntryLo = (DBITON & GBITOFF) & VBITOFF;
+	for(i = 0; i < PGDIR_SIZE; i++) {
+		currentSupport->sup_pgDir[i] = NULL;
 	}
-	/* reset the idx 31 element */
-	currentSupport->sup_privatePgTbl[PAGE_TABLE_SIZE - 1].EntryHi = UPROC_STACK_AREA + (currentSupport->sup_asid << ASID_SHIFT);
+	currentSupport->sup_leafCount = 0;
 }
 
 /**********************************************************
- *  init_Uproc
+ *  init_Uproc_support
  *
- *  Initializes a U-proc's state, support structure, and
- *  exception contexts. Also sets up its page table and
- *  creates a new PCB by calling SYS1.
+ *  Initializes a U-proc's support structure: its ASID, its
+ *  exception contexts and an empty page table. Also used by
+ *  FORK for the support structure of the child.
  *
  *  Parameters:
  *         support_t *initSupportPTR – pointer to support struct
@@ -69,16 +78,7 @@ void init_Uproc_pgTable(support_t *currentSupport) {
  *  Returns:
  *
  **********************************************************/
-int init_Uproc(support_t *initSupportPTR, int ASID) {
-	state_t initState;
-
-	initState.s_pc = UPROCSTARTADDR;
-	initState.s_t9 = UPROCSTARTADDR;
-	initState.s_sp = UPROCSTACK;
-	initState.s_status = ((IEPBITON | TEBITON) | IPBITS) | KUPBITON;
-
-	initState.s_entryHI = (ASID << ASID_SHIFT);
-
+void init_Uproc_support(support_t *initSupportPTR, int ASID) {
 	initSupportPTR->sup_asid = ASID;
 
 	initSupportPTR->sup_exceptContext[PGFAULTEXCEPT].c_pc = (memaddr)TLB_exception_handler;
@@ -93,6 +93,33 @@ int init_Uproc(support_t *initSupportPTR, int ASID) {
 	initSupportPTR->delaySem = 0;
 
 	init_Uproc_pgTable(initSupportPTR);
+}
+
+/**********************************************************
+ *  init_Uproc
+ *
+ *  Initializes a U-proc's state, support structure, and
+ *  exception contexts. Also sets up its page table and
+ *  creates a new PCB by calling SYS1.
+ *
+ *  Parameters:
+ *         support_t *initSupportPTR – pointer to support struct
+ *         int ASID – unique ID of the user process
+ *
+ *  Returns:
+ *
+ **********************************************************/
+int init_Uproc(support_t *initSupportPTR, int ASID) {
+	state_t initState;
+
+	initState.s_pc = UPROCSTARTADDR;
+	initState.s_t9 = UPROCSTARTADDR;
+	initState.s_sp = UPROCSTACK;
+	initState.s_status = ((IEPBITON | TEBITON) | IPBITS) | KUPBITON;
+
+	initState.s_entryHI = (ASID << ASID_SHIFT);
+
+	init_Uproc_support(initSupportPTR, ASID);
 
 	int newPcbStat = SYSCALL(1, &initState, initSupportPTR, 0);
 	return newPcbStat;
@@ -121,18 +148,12 @@ void helper_copy_block(int *src, int *dst){
 int helper_read_flash(int devNo, int blockNo){
     int flash_sem_idx = devSemIdx(FLASHINT, devNo, FALSE);
 
-    device_t *flash_dev_reg_addr = devAddrBase(FLASHINT, devNo);
-
 	/*delete this condition out after finishing -- this should never be called*/
-    if (blockNo > 32){
+    if (blockNo > UPROC_IMAGE_PAGES){
         SYSCALL(TERMINATETHREAD, 0, 0, 0);
     }
     
-    flash_dev_reg_addr->d_data0 = FLASK_DMA_BUFFER_BASE_ADDR + (BLOCKSIZE*devNo);
-    setSTATUS(getSTATUS() & (~IECBITON));
-    	flash_dev_reg_addr->d_command = (blockNo << BLOCKNUM_SHIFT) + READBLK_FLASH;
-        int flash_status = SYSCALL(IOWAIT, FLASHINT, devNo, 0);
-    setSTATUS(getSTATUS() | IECBITON);
+    int flash_status = SYSCALL(DOIO, doioDev(FLASHINT, devNo, FALSE), (blockNo << BLOCKNUM_SHIFT) + READBLK_FLASH, flashDmaBuf + (BLOCKSIZE*devNo));
 
     if (flash_status == READY){
         return flash_status;
@@ -159,19 +180,36 @@ int helper_write_disk(int secNo2D){
     int sectNo = (secNo2D % (maxhead * maxsect)) % maxsect;
 	int headNo = (secNo2D % (maxhead * maxsect)) / maxsect; /*divide and round down*/
     int cylNo = secNo2D / (maxhead * maxsect);
-    setSTATUS(getSTATUS() & (~IECBITON));
-        disk_dev_reg_addr->d_command = (cylNo << CYLNUM_SHIFT) + SEEKCYL; /*seek*/
-        int disk_status = SYSCALL(IOWAIT, DISKINT, devNo, 0);
-    setSTATUS(getSTATUS() | IECBITON);
+    int disk_status = SYSCALL(DOIO, doioDev(DISKINT, devNo, FALSE), (cylNo << CYLNUM_SHIFT) + SEEKCYL, 0); /*seek*/
     if (disk_status != READY){
         SYSCALL(VERHO, &(mutex[disk_sem_idx]), 0, 0);
         return 0 - disk_status;
     }
-    disk_dev_reg_addr->d_data0 = DISK_DMA_BUFFER_BASE_ADDR + (BLOCKSIZE*devNo); /*carefull not to do anything with device between writing to data0 and command*/
-    setSTATUS(getSTATUS() & (~IECBITON));
-        disk_dev_reg_addr->d_command = (headNo << HEADNUM_SHIFT) + (sectNo << SECTNUM_SHIFT) + WRITEBLK_DSK; /*write*/
-        disk_status = SYSCALL(IOWAIT, DISKINT, devNo, 0);
-    setSTATUS(getSTATUS() | IECBITON);
+    disk_status = SYSCALL(DOIO, doioDev(DISKINT, devNo, FALSE), (headNo << HEADNUM_SHIFT) + (sectNo << SECTNUM_SHIFT) + WRITEBLK_DSK, diskDmaBuf + (BLOCKSIZE*devNo)); /*write*/
+
+    if (disk_status == READY){
+        return disk_status;
+    } else {
+        return 0 - disk_status;
+    }
+}
+
+int helper_read_disk(int secNo2D){
+    int devNo = RESERVED_DISK_NO;
+
+    device_t *disk_dev_reg_addr = devAddrBase(DISKINT, devNo);
+
+    int maxhead = ((disk_dev_reg_addr->d_data1) >> 8) & 0xFF;
+    int maxsect = (disk_dev_reg_addr->d_data1) & 0xFF;
+
+    int sectNo = (secNo2D % (maxhead * maxsect)) % maxsect;
+	int headNo = (secNo2D % (maxhead * maxsect)) / maxsect; /*divide and round down*/
+    int cylNo = secNo2D / (maxhead * maxsect);
+    int disk_status = SYSCALL(DOIO, doioDev(DISKINT, devNo, FALSE), (cylNo << CYLNUM_SHIFT) + SEEKCYL, 0); /*seek*/
+    if (disk_status != READY){
+        return 0 - disk_status;
+    }
+    disk_status = SYSCALL(DOIO, doioDev(DISKINT, devNo, FALSE), (headNo << HEADNUM_SHIFT) + (sectNo << SECTNUM_SHIFT) + READBLK_DSK, diskDmaBuf + (BLOCKSIZE*devNo)); /*read*/
 
     if (disk_status == READY){
         return disk_status;
@@ -180,9 +218,80 @@ int helper_write_disk(int secNo2D){
     }
 }
 
+/**********************************************************
+ *  helper_page_hash
+ *
+ *  FNV-1a hash of the words of a page.
+ *
+ *  Parameters:
+ *         int *page – the page
+ *
+ *  Returns:
+ *         unsigned int – its hash
+ **********************************************************/
+HIDDEN unsigned int helper_page_hash(int *page) {
+	unsigned int hash = 2166136261U;
+	int i;
+	for(i = 0; i < BLOCKSIZE / WORDLEN; i++) {
+		hash = (hash ^ (unsigned int)page[i]) * 16777619U;
+	}
+	return hash;
+}
+
+/**********************************************************
+ *  helper_same_page
+ *
+ *  Compares two pages word by word.
+ *
+ *  Parameters:
+ *         int *a, int *b – the pages
+ *
+ *  Returns:
+ *         int – TRUE if they are identical
+ **********************************************************/
+HIDDEN int helper_same_page(int *a, int *b) {
+	int i;
+	for(i = 0; i < BLOCKSIZE / WORDLEN; i++) {
+		if(a[i] != b[i]) {
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/**********************************************************
+ *  helper_find_staged
+ *
+ *  Looks for a page identical to the one in the flash buffer
+ *  of devNo among the pages staged before it: a page with the
+ *  same hash is read back from the swap disk and compared.
+ *
+ *  Parameters:
+ *         int devNo – flash device of the page
+ *         int pageNo – page of the image
+ *
+ *  Returns:
+ *         int – sector of the identical page, -1 if none
+ **********************************************************/
+HIDDEN int helper_find_staged(int devNo, int pageNo) {
+	int k, d, p;
+	for(k = 0; k < UPROC_IMAGE_PAGES * devNo + pageNo; k++) {
+		d = k / UPROC_IMAGE_PAGES;
+		p = k % UPROC_IMAGE_PAGES;
+		/* only pages written to their own sector */
+		if(imageHash[d][p] == imageHash[devNo][pageNo] && imageSect[d][p] == k &&
+		   helper_read_disk(k) == READY &&
+		   helper_same_page((int *) (flashDmaBuf + (BLOCKSIZE*devNo)), (int *) (diskDmaBuf + (BLOCKSIZE*devNo)))) {
+			return k;
+		}
+	}
+	return -1;
+}
+
 void set_up_backing_store(){
 	int devNo;
 	int pageNo;
+	int sharedSect;
 
 	int flash_sem_idx;
 	int disk_sem_idx = devSemIdx(DISKINT, RESERVED_DISK_NO, FALSE);
@@ -191,18 +300,31 @@ void set_up_backing_store(){
 	int disk_status;
 	
 
+	for (devNo = 0; devNo < MAXUPROC; devNo++){
+		for (pageNo = 0; pageNo < UPROC_IMAGE_PAGES; pageNo++){
+			imageSect[devNo][pageNo] = UPROC_IMAGE_PAGES*devNo + pageNo;
+		}
+	}
+
 	SYSCALL(PASSERN, &(mutex[disk_sem_idx]), 0, 0);
 	for (devNo = 0; devNo < UPROC_NUM; devNo++){
-		for (pageNo = 0; pageNo < PAGE_TABLE_SIZE; pageNo++){
+		for (pageNo = 0; pageNo < UPROC_IMAGE_PAGES; pageNo++){
 			flash_sem_idx = devSemIdx(FLASHINT, devNo, FALSE);
 
 			SYSCALL(PASSERN, &(mutex[flash_sem_idx]), 0, 0);
 
 				flash_status = helper_read_flash(devNo, pageNo);
-				
-				helper_copy_block(FLASK_DMA_BUFFER_BASE_ADDR + (BLOCKSIZE*devNo), DISK_DMA_BUFFER_BASE_ADDR + (BLOCKSIZE*devNo));
-				
-				disk_status = helper_write_disk(32*devNo + pageNo);
+
+				/* an identical page staged before is shared instead of written again */
+				imageHash[devNo][pageNo] = helper_page_hash((int *) (flashDmaBuf + (BLOCKSIZE*devNo)));
+				sharedSect = helper_find_staged(devNo, pageNo);
+				if (sharedSect != -1){
+					imageSect[devNo][pageNo] = sharedSect;
+				} else {
+					helper_copy_block(flashDmaBuf + (BLOCKSIZE*devNo), diskDmaBuf + (BLOCKSIZE*devNo));
+
+					disk_status = helper_write_disk(UPROC_IMAGE_PAGES*devNo + pageNo);
+				}
 
 			SYSCALL(VERHO, &(mutex[flash_sem_idx]), 0, 0);
 		}
@@ -214,7 +336,9 @@ void set_up_backing_store(){
  *  test
  *
  *  Function for initializing the system test.
- *  - Initializes swap structures and mutexes
+ *  - Takes the DMA buffers from the frames past the kernel image
+ *  - Initializes swap structures and mutexes; the swap pool gets
+ *    the frames left
  *  - Sets 8 user processes with init_Uproc()
  *  - Waits for all user processes to finish
  *
@@ -230,9 +354,14 @@ void test() {
 		mutex[i] = 1;
 	}
 	
+	diskDmaBuf = phys_alloc(DEVPERINT);
+	flashDmaBuf = phys_alloc(DEVPERINT);
 	initSwapStruct();
 	set_up_backing_store();
 	initADL();
+	initMsgBoxes();
+	initForkTable();
+	initLoadControl();
 
 	support_t initSupportPTRArr[UPROC_NUM + 1]; /*1 extra sentinel node*/
 
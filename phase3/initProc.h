@@ -16,7 +16,12 @@
 #include "../h/const.h"
 
 void test();
+void init_Uproc_support(support_t *initSupportPTR, int ASID);
+void helper_copy_block(int *src, int *dst);
 extern int mutex[DEVINTNUM * DEVPERINT + DEVPERINT];
 extern int masterSemaphore;
+extern int imageSect[MAXUPROC][UPROC_IMAGE_PAGES];
+extern memaddr diskDmaBuf;
+extern memaddr flashDmaBuf;
 
 #endif
\ No newline at end of file
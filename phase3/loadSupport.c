@@ -0,0 +1,330 @@
+/*********************************LOADSUPPORT.C*******************************
+ *
+ *  Load Control Module
+ *
+ *  When the working sets of the U-procs together exceed the swap pool,
+ *  every U-proc faults all the time and the swap pool and its devices
+ *  become the bottleneck of the whole system. This module watches the
+ *  page fault rate, over windows of LOAD_WINDOW us, and the resident set
+ *  of every ASID, counted in the swap pool table when a window closes.
+ *  - A window with at least LOAD_HIGH_FAULTS faults and no free frame
+ *    means thrashing: the U-proc with the lowest priority, the fewest
+ *    stride tickets, is suspended. Of those with equal tickets, the one
+ *    that faulted most goes. EDF U-procs and the last running U-proc are
+ *    never suspended.
+ *  - A suspended U-proc is held at its next page fault, blocked on the
+ *    pseudo-clock, so off the ready queue, and the pager evicts its
+ *    frames before any other (page_replace()): it is swapped out
+ *    lazily, as the others need its frames. A suspended U-proc that
+ *    does not fault again, its working set being resident, is not
+ *    held and keeps running; it faults soon enough once the others
+ *    have taken its frames, and is held then.
+ *  - A window with at most LOAD_LOW_FAULTS faults, or with enough free
+ *    frames for the resident set it had when suspended, lets the
+ *    suspended U-proc with the highest priority back in.
+ *  At most one U-proc is suspended or let back in per window. The held
+ *  U-procs check the load themselves on every pseudo-clock tick, so they
+ *  are let back in even when nobody else faults any more.
+ *
+ *      Written by Phuong and Oghap on Oct 2026
+ */
+
+#include "loadSupport.h"
+#include "vmSupport.h"
+
+loadStat_t loadStats[MAXUPROC + 1]; /* load control of each ASID */
+
+HIDDEN int loadMutex = 1;                 /* everything below */
+HIDDEN cpu_t loadWindowStart;             /* TOD the current window started at */
+HIDDEN int loadWindowFaults;              /* page faults in the current window */
+HIDDEN int loadFaults[MAXUPROC + 1];      /* page faults in the current window, by ASID */
+HIDDEN int loadState[MAXUPROC + 1];       /* LOAD_IDLE, LOAD_ACTIVE or LOAD_SUSPENDED */
+HIDDEN int loadTickets[MAXUPROC + 1];     /* stride tickets, the priority */
+HIDDEN int loadRealTime[MAXUPROC + 1];    /* TRUE for EDF U-procs, never suspended */
+HIDDEN int loadRss[MAXUPROC + 1];         /* frames held, as of the last window */
+
+/**********************************************************
+ *  initLoadControl
+ *
+ *  Starts the first window with every ASID idle, with the
+ *  default tickets.
+ *
+ *  Parameters:
+ *
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void initLoadControl() {
+	int i;
+	for(i = 0; i <= MAXUPROC; i++) {
+		loadFaults[i] = 0;
+		loadState[i] = LOAD_IDLE;
+		loadTickets[i] = STRIDE_DEFAULT_TICKETS;
+		loadRealTime[i] = FALSE;
+		loadRss[i] = 0;
+		loadStats[i].l_suspends = 0;
+		loadStats[i].l_heldTime = 0;
+	}
+	loadWindowFaults = 0;
+	STCK(loadWindowStart);
+}
+
+/**********************************************************
+ *  load_pick_victim
+ *
+ *  Picks the running U-proc to suspend: the fewest tickets,
+ *  then the most faults in the window. Must be called
+ *  holding the load control mutex.
+ *
+ *  Parameters:
+ *
+ *
+ *  Returns:
+ *         int – its ASID, -1 if no U-proc may be suspended
+ **********************************************************/
+HIDDEN int load_pick_victim() {
+	int asid, running = 0, victim = -1;
+
+	for(asid = 1; asid <= MAXUPROC; asid++) {
+		if(loadState[asid] != LOAD_ACTIVE) {
+			continue;
+		}
+		running++;
+		if(loadRealTime[asid] == TRUE) {
+			continue;
+		}
+		if(victim == -1 || loadTickets[asid] < loadTickets[victim] || (loadTickets[asid] == loadTickets[victim] && loadFaults[asid] > loadFaults[victim])) {
+			victim = asid;
+		}
+	}
+	/* somebody has to keep running */
+	return (running > 1) ? victim : -1;
+}
+
+/**********************************************************
+ *  load_pick_readmit
+ *
+ *  Picks the suspended U-proc to let back in: the most
+ *  tickets, then the smallest resident set when suspended,
+ *  the cheapest to bring back. Must be called holding the
+ *  load control mutex.
+ *
+ *  Parameters:
+ *
+ *
+ *  Returns:
+ *         int – its ASID, -1 if none is suspended
+ **********************************************************/
+HIDDEN int load_pick_readmit() {
+	int asid, best = -1;
+
+	for(asid = 1; asid <= MAXUPROC; asid++) {
+		if(loadState[asid] != LOAD_SUSPENDED) {
+			continue;
+		}
+		if(best == -1 || loadTickets[asid] > loadTickets[best] || (loadTickets[asid] == loadTickets[best] && loadRss[asid] < loadRss[best])) {
+			best = asid;
+		}
+	}
+	return best;
+}
+
+/**********************************************************
+ *  load_check
+ *
+ *  Closes the current window once it has lasted LOAD_WINDOW
+ *  us: suspends a U-proc if the pager thrashed, or lets one
+ *  back in if the fault rate dropped. The frames are counted
+ *  holding the swap pool semaphore. Must be called holding
+ *  the load control mutex, which is always taken before the
+ *  swap pool semaphore.
+ *
+ *  Parameters:
+ *
+ *
+ *  Returns:
+ *
+ **********************************************************/
+HIDDEN void load_check() {
+	cpu_t now;
+	int i, freeFrames, asid;
+	int rss[MAXUPROC + 1];
+
+	STCK(now);
+	if(now - loadWindowStart < LOAD_WINDOW) {
+		return;
+	}
+
+	freeFrames = 0;
+	for(i = 0; i <= MAXUPROC; i++) {
+		rss[i] = 0;
+	}
+	SYSCALL(PASSERN, &swapPoolSema4, 0, 0);
+	for(i = 0; i < swapPoolSize; i++) {
+		asid = swapPoolTable[i].ASID;
+		if(asid == -1) {
+			freeFrames++;
+		} else if(asid > 0 && asid <= MAXUPROC) {
+			rss[asid]++;
+		}
+	}
+	SYSCALL(VERHO, &swapPoolSema4, 0, 0);
+	if(loadWindowFaults >= LOAD_HIGH_FAULTS && freeFrames == 0) {
+		asid = load_pick_victim();
+		if(asid != -1) {
+			loadState[asid] = LOAD_SUSPENDED;
+			loadRss[asid] = rss[asid];
+			loadStats[asid].l_suspends++;
+		}
+	} else {
+		asid = load_pick_readmit();
+		if(asid != -1 && (loadWindowFaults <= LOAD_LOW_FAULTS || freeFrames >= loadRss[asid])) {
+			loadState[asid] = LOAD_ACTIVE;
+		}
+	}
+
+	loadWindowStart = now;
+	loadWindowFaults = 0;
+	for(i = 0; i <= MAXUPROC; i++) {
+		loadFaults[i] = 0;
+	}
+}
+
+/**********************************************************
+ *  load_fault
+ *
+ *  Counts a page fault, closing the window if it is over.
+ *  Called by the pager for every fault it serves, before it
+ *  takes the swap pool semaphore.
+ *
+ *  Parameters:
+ *         int asid – ASID of the faulting U-proc
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void load_fault(int asid) {
+	SYSCALL(PASSERN, &loadMutex, 0, 0);
+	loadWindowFaults++;
+	loadFaults[asid]++;
+	load_check();
+	SYSCALL(VERHO, &loadMutex, 0, 0);
+}
+
+/**********************************************************
+ *  load_admit
+ *
+ *  Called on every page fault before it is served. A
+ *  suspended U-proc is held here, waiting on the pseudo-clock
+ *  and checking the load on every tick, until it is let back
+ *  in. A fault taken in kernel mode is never held: the
+ *  Support Level may be holding a semaphore (a mailbox slot,
+ *  a device mutex) while it touches a U-proc page.
+ *
+ *  Parameters:
+ *         support_t *currentSupport – support struct of the faulting U-proc
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void load_admit(support_t *currentSupport) {
+	int asid = currentSupport->sup_asid;
+	cpu_t heldStart, heldEnd;
+
+	SYSCALL(PASSERN, &loadMutex, 0, 0);
+	if(loadState[asid] == LOAD_IDLE) {
+		loadState[asid] = LOAD_ACTIVE;
+	}
+	if(loadState[asid] == LOAD_SUSPENDED && (currentSupport->sup_exceptState[PGFAULTEXCEPT].s_status & KUPBITON) != 0) {
+		STCK(heldStart);
+		while(loadState[asid] == LOAD_SUSPENDED) {
+			SYSCALL(VERHO, &loadMutex, 0, 0);
+			SYSCALL(CLOCKWAIT, 0, 0, 0);
+			SYSCALL(PASSERN, &loadMutex, 0, 0);
+			load_check();
+		}
+		STCK(heldEnd);
+		loadStats[asid].l_heldTime += heldEnd - heldStart;
+	}
+	SYSCALL(VERHO, &loadMutex, 0, 0);
+}
+
+/**********************************************************
+ *  load_suspended
+ *
+ *  Tells the pager whether the frames of an ASID should be
+ *  evicted first. Read without the mutex: a stale answer
+ *  only picks a different victim.
+ *
+ *  Parameters:
+ *         int asid – ASID, -1 for a free frame
+ *
+ *  Returns:
+ *         int – TRUE if the U-proc is suspended
+ **********************************************************/
+int load_suspended(int asid) {
+	return asid > 0 && loadState[asid] == LOAD_SUSPENDED;
+}
+
+/**********************************************************
+ *  load_set_tickets
+ *
+ *  Records the priority of a U-proc, set by SETSHARE.
+ *
+ *  Parameters:
+ *         int asid – ASID of the U-proc
+ *         int tickets – its stride tickets
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void load_set_tickets(int asid, int tickets) {
+	SYSCALL(PASSERN, &loadMutex, 0, 0);
+	loadTickets[asid] = tickets;
+	SYSCALL(VERHO, &loadMutex, 0, 0);
+}
+
+/**********************************************************
+ *  load_set_real_time
+ *
+ *  Exempts a U-proc admitted to the EDF class from load
+ *  control, or makes it subject again when it leaves; a
+ *  suspended one is let back in at once.
+ *
+ *  Parameters:
+ *         int asid – ASID of the U-proc
+ *         int realTime – TRUE if it is in the EDF class
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void load_set_real_time(int asid, int realTime) {
+	SYSCALL(PASSERN, &loadMutex, 0, 0);
+	loadRealTime[asid] = realTime;
+	if(realTime == TRUE && loadState[asid] == LOAD_SUSPENDED) {
+		loadState[asid] = LOAD_ACTIVE;
+	}
+	SYSCALL(VERHO, &loadMutex, 0, 0);
+}
+
+/**********************************************************
+ *  load_exit
+ *
+ *  Forgets a terminating U-proc, so that its ASID starts
+ *  idle with the default priority if a forked U-proc gets
+ *  it later.
+ *
+ *  Parameters:
+ *         int asid – ASID of the U-proc
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void load_exit(int asid) {
+	SYSCALL(PASSERN, &loadMutex, 0, 0);
+	loadState[asid] = LOAD_IDLE;
+	loadTickets[asid] = STRIDE_DEFAULT_TICKETS;
+	loadRealTime[asid] = FALSE;
+	SYSCALL(VERHO, &loadMutex, 0, 0);
+}
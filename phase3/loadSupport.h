@@ -0,0 +1,28 @@
+/************************** LOADSUPPORT.H ******************************
+ *
+ *  The externals declaration file for LOADSUPPORT Module
+ *
+ *  Written by Phuong and Oghap on Oct 2026
+ */
+
+#ifndef LOADSUPPORT_H
+#define LOADSUPPORT_H
+
+#include "/usr/include/umps3/umps/libumps.h"
+
+#include "../h/pcb.h"
+#include "../h/asl.h"
+#include "../h/types.h"
+#include "../h/const.h"
+
+extern loadStat_t loadStats[MAXUPROC + 1];
+
+void initLoadControl();
+void load_fault(int asid);
+void load_admit(support_t *currentSupport);
+int load_suspended(int asid);
+void load_set_tickets(int asid, int tickets);
+void load_set_real_time(int asid, int realTime);
+void load_exit(int asid);
+
+#endif
@@ -0,0 +1,228 @@
+/*********************************MSGSUPPORT.C*******************************
+ *
+ *  Message Passing Support Module
+ *
+ *  This module implements synchronous message passing between U-procs
+ *  through two Support Level system calls:
+ *  - SENDMSG (SYS21): a1 = destination ASID, a2 = message word,
+ *    a3 = address of a page to hand over (0 for none).
+ *    The sender blocks until the receiver has taken the message.
+ *    v0 = 0, or -1 if the destination has ended or never started.
+ *  - RECVMSG (SYS22): a1 = address of the page to receive into (0 for none),
+ *    a2 = address of an int to store the sender's ASID (0 for none).
+ *    The message word is returned in v0.
+ *
+ *  Small messages travel in registers. Page sized payloads are not copied:
+ *  the sender's swap pool frame is pinned and then remapped into the
+ *  receiver's page table by the pager (see remap_swap_frame()).
+ *
+ *      Written by Phuong and Oghap on Oct 2026
+ */
+
+#include "msgSupport.h"
+#include "initProc.h"
+#include "vmSupport.h"
+#include "sysSupport.h"
+
+HIDDEN msgBox_t msgBoxes[MAXUPROC];
+
+/**********************************************************
+ *  initMsgBoxes
+ *
+ *  Initializes the mailbox of every possible ASID.
+ *
+ *  Parameters:
+ *
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void initMsgBoxes() {
+	int i;
+	for(i = 0; i < MAXUPROC; i++) {
+		msgBoxes[i].mb_slotMutex = 1;
+		msgBoxes[i].mb_recvSem = 0;
+		msgBoxes[i].mb_doneSem = 0;
+		msgBoxes[i].mb_senderASID = -1;
+		msgBoxes[i].mb_word = 0;
+		msgBoxes[i].mb_frame = -1;
+		msgBoxes[i].mb_openMutex = 1;
+		/* the ASIDs above UPROC_NUM only receive once FORK hands them out */
+		msgBoxes[i].mb_closed = (i >= UPROC_NUM);
+	}
+}
+
+/**********************************************************
+ *  helper_check_page_addr
+ *
+ *  Returns TRUE if the given address is not the start of a
+ *  page of the U-proc's logical address space, kuseg up to
+ *  the top of the U-proc stack (exclusive).
+ *
+ *  Parameters:
+ *         int pgAdd – virtual address of the page
+ *
+ *  Returns:
+ *         int – TRUE if address is invalid, FALSE otherwise
+ **********************************************************/
+HIDDEN int helper_check_page_addr(int pgAdd) {
+	unsigned int page = (unsigned int)pgAdd;
+
+	if((page & (PAGESIZE - 1)) != 0) {
+		return TRUE;
+	}
+	if(page >= KUSEG && page < UPROCSTACK) {
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**********************************************************
+ *  SEND_MSG
+ *
+ *  Posts a message in the destination's mailbox and blocks
+ *  until the destination has received it, or until the
+ *  destination ends (see close_msg_box()).
+ *
+ *  Parameters:
+ *         support_t *passedUpSupportStruct – pointer to the support struct
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void SEND_MSG(support_t *passedUpSupportStruct) {
+	state_t *savedExcState = &(passedUpSupportStruct->sup_exceptState[GENERALEXCEPT]);
+	int destASID = savedExcState->s_a1;
+
+	/* Error: no such U-proc, or sending to itself would never return */
+	/* Error: page address not page aligned or outside the logical address space */
+	if(destASID < 1 || destASID > MAXUPROC || destASID == passedUpSupportStruct->sup_asid || (savedExcState->s_a3 != 0 && helper_check_page_addr(savedExcState->s_a3))) {
+		program_trap_handler(passedUpSupportStruct, NULL);
+	}
+
+	msgBox_t *box = &(msgBoxes[destASID - 1]);
+
+	SYSCALL(PASSERN, &(box->mb_slotMutex), 0, 0);
+	SYSCALL(PASSERN, &(box->mb_openMutex), 0, 0);
+	if(box->mb_closed) {
+		SYSCALL(VERHO, &(box->mb_openMutex), 0, 0);
+		SYSCALL(VERHO, &(box->mb_slotMutex), 0, 0);
+		savedExcState->s_v0 = -1;
+		return;
+	}
+	box->mb_senderASID = passedUpSupportStruct->sup_asid;
+	box->mb_word = savedExcState->s_a2;
+	box->mb_frame = -1;
+	if(savedExcState->s_a3 != 0) {
+		box->mb_frame = pin_page(passedUpSupportStruct, savedExcState->s_a3);
+	}
+	/* wake the receiver, then wait for it to take the message */
+	SYSCALL(VERHO, &(box->mb_recvSem), 0, 0);
+	SYSCALL(VERHO, &(box->mb_openMutex), 0, 0);
+	SYSCALL(PASSERN, &(box->mb_doneSem), 0, 0);
+
+	/* close_msg_box() clears the sender when the message was never taken */
+	savedExcState->s_v0 = 0;
+	if(box->mb_senderASID == -1) {
+		savedExcState->s_v0 = -1;
+	}
+	SYSCALL(VERHO, &(box->mb_slotMutex), 0, 0);
+}
+
+/**********************************************************
+ *  RECV_MSG
+ *
+ *  Blocks until a message is posted in the Current Process's
+ *  mailbox, takes it, and releases the sender.
+ *
+ *  Parameters:
+ *         support_t *passedUpSupportStruct – pointer to the support struct
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void RECV_MSG(support_t *passedUpSupportStruct) {
+	state_t *savedExcState = &(passedUpSupportStruct->sup_exceptState[GENERALEXCEPT]);
+
+	/* Error: page address not page aligned or outside the logical address space */
+	/* Error: sender ASID would be stored outside the logical address space */
+	if((savedExcState->s_a1 != 0 && helper_check_page_addr(savedExcState->s_a1)) || (savedExcState->s_a2 != 0 && helper_check_string_outside_addr_space(savedExcState->s_a2))) {
+		program_trap_handler(passedUpSupportStruct, NULL);
+	}
+
+	msgBox_t *box = &(msgBoxes[passedUpSupportStruct->sup_asid - 1]);
+
+	SYSCALL(PASSERN, &(box->mb_recvSem), 0, 0);
+
+	if(box->mb_frame != -1) {
+		if(savedExcState->s_a1 != 0) {
+			if(remap_swap_frame(box->mb_frame, passedUpSupportStruct, savedExcState->s_a1) == FALSE) {
+				/* no page table left for the page: release the sender before dying */
+				unpin_swap_frame(box->mb_frame);
+				SYSCALL(VERHO, &(box->mb_doneSem), 0, 0);
+				program_trap_handler(passedUpSupportStruct, NULL);
+			}
+		} else {
+			/* the receiver does not want the page, the sender keeps it */
+			unpin_swap_frame(box->mb_frame);
+		}
+	}
+	if(savedExcState->s_a2 != 0) {
+		*((int *)savedExcState->s_a2) = box->mb_senderASID;
+	}
+	savedExcState->s_v0 = box->mb_word;
+
+	/* the slot can now be reused by the next sender */
+	SYSCALL(VERHO, &(box->mb_doneSem), 0, 0);
+}
+
+/**********************************************************
+ *  open_msg_box
+ *
+ *  Lets senders post to an ASID again, once it is handed
+ *  to a new U-proc.
+ *
+ *  Parameters:
+ *         int asid – ASID of the new U-proc
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void open_msg_box(int asid) {
+	msgBox_t *box = &(msgBoxes[asid - 1]);
+
+	SYSCALL(PASSERN, &(box->mb_openMutex), 0, 0);
+	box->mb_closed = FALSE;
+	SYSCALL(VERHO, &(box->mb_openMutex), 0, 0);
+}
+
+/**********************************************************
+ *  close_msg_box
+ *
+ *  Called by an ending U-proc for its own mailbox: later
+ *  senders get -1 at once, and a sender whose message was
+ *  posted but not taken is released with -1 and keeps its
+ *  page. Only the owner of the mailbox takes mb_recvSem, so
+ *  its value is stable under mb_openMutex.
+ *
+ *  Parameters:
+ *         int asid – ASID of the ending U-proc
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void close_msg_box(int asid) {
+	msgBox_t *box = &(msgBoxes[asid - 1]);
+
+	SYSCALL(PASSERN, &(box->mb_openMutex), 0, 0);
+	box->mb_closed = TRUE;
+	if(box->mb_recvSem > 0) {
+		SYSCALL(PASSERN, &(box->mb_recvSem), 0, 0);
+		if(box->mb_frame != -1) {
+			unpin_swap_frame(box->mb_frame);
+		}
+		box->mb_senderASID = -1;
+		SYSCALL(VERHO, &(box->mb_doneSem), 0, 0);
+	}
+	SYSCALL(VERHO, &(box->mb_openMutex), 0, 0);
+}
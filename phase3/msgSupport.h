@@ -0,0 +1,24 @@
+/************************** MSGSUPPORT.H ******************************
+ *
+ *  The externals declaration file for MSGSUPPORT Module
+ *
+ *  Written by Phuong and Oghap on Oct 2026
+ */
+
+#ifndef MSGSUPPORT_H
+#define MSGSUPPORT_H
+
+#include "/usr/include/umps3/umps/libumps.h"
+
+#include "../h/pcb.h"
+#include "../h/asl.h"
+#include "../h/types.h"
+#include "../h/const.h"
+
+void initMsgBoxes();
+void SEND_MSG(support_t *passedUpSupportStruct);
+void RECV_MSG(support_t *passedUpSupportStruct);
+void open_msg_box(int asid);
+void close_msg_box(int asid);
+
+#endif
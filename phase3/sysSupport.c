@@ -14,6 +14,10 @@
  *    instructions executed by a user process.
  *  - A General Exception handler that dispatches to appropriate
  *    handlers or terminates the process if the exception is unhandled.
+ *  - FORK, which clones the calling U-proc copy-on-write under one of
+ *    the ASIDs test() leaves unused, with a support structure from a
+ *    pool of FORK_MAX. A U-proc outlives none of its forked children:
+ *    SYS2 would take them with it, so it waits for them to end first.
  *
  *      Modified by Phuong and Oghap on March 2025
  */
@@ -23,12 +27,33 @@
 #include "vmSupport.h"
 #include "../phase4/devSupport.h"
 #include "../phase5/delayDaemon.h"
+#include "msgSupport.h"
+#include "loadSupport.h"
+#include "../phase2/histogram.h"
+#include "../phase2/trace.h"
+#include "../phase2/prof.h"
+#include "../phase2/scheduler.h"
+
+HIDDEN char *histNames[HIST_KINDS] = {"refill", "pgfault", "iowait disk", "iowait flash", "iowait net", "iowait printer", "iowait term"};
+
+HIDDEN int traceDumpSem = 1;                        /* one TRACEDUMP at a time */
+HIDDEN unsigned int traceDrained = 0;               /* first event not printed yet */
+HIDDEN traceEvent_t traceSnapshot[TRACE_ENTRIES];   /* events being printed */
+HIDDEN int profSem = 1;                             /* one PROFILE at a time */
+
+HIDDEN int forkSem = 1;                             /* one FORK or forked U-proc end at a time */
+HIDDEN support_t forkSupport[FORK_MAX];             /* support structs of the forked U-procs */
+HIDDEN int forkAsid[FORK_MAX];                      /* ASID using each of them, 0 if free */
+HIDDEN int forkParent[MAXUPROC + 1];                /* ASID of the U-proc that forked it, 0 if started by test() */
+HIDDEN int forkChildren[MAXUPROC + 1];              /* forked U-procs, each V'ing forkExitSem once, ended or not */
+HIDDEN int forkExitSem[MAXUPROC + 1];               /* V'd by each of them when it ends */
 
 /**********************************************************
  *  helper_check_string_outside_addr_space
  *
  *  Returns TRUE if the given string address falls outside
- *  the allowed logical address space for the user process.
+ *  the allowed logical address space for the user process,
+ *  i.e. kuseg up to the top of the U-proc stack.
  *
  *  Parameters:
  *         int strAdd – virtual address of the string
@@ -37,7 +62,7 @@
  *         int – TRUE if address is invalid, FALSE otherwise
  **********************************************************/
 int helper_check_string_outside_addr_space(int strAdd) {
-	if((strAdd < KUSEG || strAdd > (LAST_USER_PAGE + PAGESIZE)) && (strAdd < UPROC_STACK_AREA || strAdd > (UPROC_STACK_AREA + PAGESIZE))) {
+	if(strAdd < KUSEG || strAdd >= UPROCSTACK) {
 		return TRUE;
 	}
 	return FALSE;
@@ -82,10 +107,96 @@ void program_trap_handler(support_t *passedUpSupportStruct, semd_t *heldSemd) {
 }
 
 /**********************************************************
- *  TERMINATE
+ *  helper_num_to_str
+ *
+ *  Writes an unsigned number in decimal into a buffer.
+ *
+ *  Parameters:
+ *         unsigned int num – the number
+ *         char *buf – destination, at least 10 chars
+ *
+ *  Returns:
+ *         int – number of chars written
+ **********************************************************/
+HIDDEN int helper_num_to_str(unsigned int num, char *buf) {
+	char digits[10];
+	int len = 0;
+	int i;
+	do {
+		digits[len] = '0' + (num % 10);
+		num = num / 10;
+		len++;
+	} while(num != 0);
+	for(i = 0; i < len; i++) {
+		buf[i] = digits[len - 1 - i];
+	}
+	return len;
+}
+
+/**********************************************************
+ *  helper_append
+ *
+ *  Appends a NUL terminated string to a buffer.
  *
- *  Terminates a user process. Releases its occupied frames,
- *  marks pages invalid, and performs SYS2 to kill the process.
+ *  Parameters:
+ *         char *buf – destination
+ *         int len – chars already in the destination
+ *         char *str – string to append
+ *
+ *  Returns:
+ *         int – new length of the destination
+ **********************************************************/
+HIDDEN int helper_append(char *buf, int len, char *str) {
+	while(*str != EOS) {
+		buf[len] = *str;
+		len++;
+		str++;
+	}
+	return len;
+}
+
+/**********************************************************
+ *  helper_print_kernel_string
+ *
+ *  Writes a string held in kernel memory to a printer device,
+ *  one character at a time, like WRITE_TO_PRINTER.
+ *
+ *  Parameters:
+ *         int devNo – printer device number
+ *         char *str – the string
+ *         int len – its length
+ *
+ *  Returns:
+ *
+ **********************************************************/
+HIDDEN void helper_print_kernel_string(int devNo, char *str, int len) {
+	int mutexSemIdx = devSemIdx(PRNTINT, devNo, FALSE);
+	int i;
+	int devStatus;
+
+	SYSCALL(PASSERN, &(mutex[mutexSemIdx]), 0, 0);
+	for(i = 0; i < len; i++) {
+		devStatus = SYSCALL(DOIO, doioDev(PRNTINT, devNo, FALSE), PRINTCHR, str[i]);
+		if(devStatus != READY) {
+			break;
+		}
+	}
+	SYSCALL(VERHO, &(mutex[mutexSemIdx]), 0, 0);
+}
+
+/**********************************************************
+ *  print_latency_summary
+ *
+ *  Prints one line per non-empty latency histogram of the
+ *  U-proc on its printer: sample count, mean, and the upper
+ *  bound of the highest non-empty bucket. The histograms of
+ *  the ASID are then reset for its next user. One more line
+ *  gives its context switches and final quantum, another
+ *  its EDF deadline misses, if any, and a last one its use of
+ *  the compressed swap tier, if any: the compressed size of
+ *  its pages, in percent, and the share of its page-ins the
+ *  tier served. If load control suspended it, one more line
+ *  gives how often and for how long it was held.
  *
  *  Parameters:
  *         support_t *passedUpSupportStruct – pointer to the support struct
@@ -93,30 +204,541 @@ void program_trap_handler(support_t *passedUpSupportStruct, semd_t *heldSemd) {
  *  Returns:
  *
  **********************************************************/
-void TERMINATE(support_t *passedUpSupportStruct) {
-	/* Disable interrupts before touching shared structures */
-	setSTATUS(getSTATUS() & (~IECBITON));
+void print_latency_summary(support_t *passedUpSupportStruct) {
+	int asid = passedUpSupportStruct->sup_asid;
+	char line[80];
+	int len, kind, bucket, misses;
+	latHist_t *hist;
+	zswapStat_t *zs = &(zswapStats[asid]);
+	loadStat_t *ls = &(loadStats[asid]);
+
+	for(kind = 0; kind < HIST_KINDS; kind++) {
+		hist = &(latencyHist[asid][kind]);
+		if(hist->h_samples == 0) {
+			continue;
+		}
+		for(bucket = HIST_BUCKETS - 1; hist->h_count[bucket] == 0; bucket--)
+			;
+		len = helper_append(line, 0, "ASID ");
+		len += helper_num_to_str(asid, &line[len]);
+		len = helper_append(line, len, " ");
+		len = helper_append(line, len, histNames[kind]);
+		len = helper_append(line, len, ": n=");
+		len += helper_num_to_str(hist->h_samples, &line[len]);
+		len = helper_append(line, len, " avg=");
+		len += helper_num_to_str(hist->h_total / hist->h_samples, &line[len]);
+		len = helper_append(line, len, "us max<");
+		len += helper_num_to_str(1 << bucket, &line[len]);
+		len = helper_append(line, len, "us\n");
+		helper_print_kernel_string(asid - 1, line, len);
+	}
+	hist_clear(asid);
+
+	/* context switches, to compare scheduling overhead across kernels */
+	len = helper_append(line, 0, "ASID ");
+	len += helper_num_to_str(asid, &line[len]);
+	len = helper_append(line, len, " switches: ");
+	len += helper_num_to_str(SYSCALL(GETPROCSTAT, PSTAT_SWITCHES, 0, 0), &line[len]);
+	len = helper_append(line, len, " quantum: ");
+	len += helper_num_to_str(SYSCALL(GETPROCSTAT, PSTAT_QUANTUM, 0, 0), &line[len]);
+	len = helper_append(line, len, "us\n");
+	helper_print_kernel_string(asid - 1, line, len);
+
+	misses = SYSCALL(GETPROCSTAT, PSTAT_DLMISSES, 0, 0);
+	if(misses > 0) {
+		len = helper_append(line, 0, "ASID ");
+		len += helper_num_to_str(asid, &line[len]);
+		len = helper_append(line, len, " EDF deadline misses: ");
+		len += helper_num_to_str(misses, &line[len]);
+		len = helper_append(line, len, "\n");
+		helper_print_kernel_string(asid - 1, line, len);
+	}
+
+	if(zs->z_stored > 0) {
+		len = helper_append(line, 0, "ASID ");
+		len += helper_num_to_str(asid, &line[len]);
+		len = helper_append(line, len, " zswap: pages=");
+		len += helper_num_to_str(zs->z_stored, &line[len]);
+		len = helper_append(line, len, " ratio=");
+		len += helper_num_to_str((zs->z_words * WORDLEN * 100) / (zs->z_stored * PAGESIZE), &line[len]);
+		len = helper_append(line, len, "% hits=");
+		len += helper_num_to_str(zs->z_hits, &line[len]);
+		len = helper_append(line, len, " hitrate=");
+		len += helper_num_to_str((zs->z_hits + zs->z_reads == 0) ? 0 : (zs->z_hits * 100) / (zs->z_hits + zs->z_reads), &line[len]);
+		len = helper_append(line, len, "%\n");
+		helper_print_kernel_string(asid - 1, line, len);
+	}
+	zs->z_stored = 0;
+	zs->z_words = 0;
+	zs->z_hits = 0;
+	zs->z_reads = 0;
+
+	if(ls->l_suspends > 0) {
+		len = helper_append(line, 0, "ASID ");
+		len += helper_num_to_str(asid, &line[len]);
+		len = helper_append(line, len, " load control: suspended=");
+		len += helper_num_to_str(ls->l_suspends, &line[len]);
+		len = helper_append(line, len, " held=");
+		len += helper_num_to_str(ls->l_heldTime / 1000, &line[len]);
+		len = helper_append(line, len, "ms\n");
+		helper_print_kernel_string(asid - 1, line, len);
+	}
+	ls->l_suspends = 0;
+	ls->l_heldTime = 0;
+}
+
+/**********************************************************
+ *  GET_LATENCY
+ *
+ *  Copies one latency histogram of the requesting U-proc
+ *  into its buffer.
+ *  a1 – histogram kind (HIST_REFILL ... HIST_KINDS - 1)
+ *  a2 – virtual address of HIST_BUCKETS ints
+ *  v0 – number of samples in the histogram
+ *
+ *  Parameters:
+ *         support_t *passedUpSupportStruct – pointer to the support struct
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void GET_LATENCY(support_t *passedUpSupportStruct) {
+	state_t *savedExcState = &(passedUpSupportStruct->sup_exceptState[GENERALEXCEPT]);
+	int kind = savedExcState->s_a1;
+	int *buffer = (int *)savedExcState->s_a2;
+
+	/* Error: no such histogram, or buffer outside the logical address space */
+	if(kind < 0 || kind >= HIST_KINDS || helper_check_string_outside_addr_space(savedExcState->s_a2) || helper_check_string_outside_addr_space(savedExcState->s_a2 + (HIST_BUCKETS * WORDLEN) - 1)) {
+		program_trap_handler(passedUpSupportStruct, NULL);
+	}
+
+	latHist_t *hist = &(latencyHist[passedUpSupportStruct->sup_asid][kind]);
+	int i;
+	for(i = 0; i < HIST_BUCKETS; i++) {
+		buffer[i] = hist->h_count[i];
+	}
+	savedExcState->s_v0 = hist->h_samples;
+}
+
+/**********************************************************
+ *  SET_REAL_TIME
+ *
+ *  Moves the requesting U-proc to the EDF scheduling class
+ *  through the Nucleus SETEDF, which does admission control.
+ *  Load control leaves the EDF U-procs alone.
+ *  a1 – period in us, 0 to go back to round-robin
+ *  a2 – budget in us per period
+ *  a3 – relative deadline in us, 0 for the period
+ *  v0 – 0 if admitted, -1 if rejected
+ *
+ *  Parameters:
+ *         support_t *passedUpSupportStruct – pointer to the support struct
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void SET_REAL_TIME(support_t *passedUpSupportStruct) {
+	state_t *savedExcState = &(passedUpSupportStruct->sup_exceptState[GENERALEXCEPT]);
+	savedExcState->s_v0 = SYSCALL(SETEDF, savedExcState->s_a1, savedExcState->s_a2, savedExcState->s_a3);
+
+	/* load control never suspends an EDF U-proc */
+	if(savedExcState->s_a1 == 0) {
+		load_set_real_time(passedUpSupportStruct->sup_asid, FALSE);
+	} else if(savedExcState->s_v0 == 0) {
+		load_set_real_time(passedUpSupportStruct->sup_asid, TRUE);
+	}
+}
+
+/**********************************************************
+ *  GET_SCHED_STAT
+ *
+ *  Returns a scheduling statistic of the requesting U-proc.
+ *  PSTAT_FLASHBLOCKS, the size of its flash device (DATA1),
+ *  is answered here: a U-proc cannot read device registers.
+ *  a1 – PSTAT_* statistic
+ *  v0 – its value, -1 for an unknown statistic
+ *
+ *  Parameters:
+ *         support_t *passedUpSupportStruct – pointer to the support struct
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void GET_SCHED_STAT(support_t *passedUpSupportStruct) {
+	state_t *savedExcState = &(passedUpSupportStruct->sup_exceptState[GENERALEXCEPT]);
+	device_t *flashDev;
+
+	if(savedExcState->s_a1 == PSTAT_FLASHBLOCKS) {
+		flashDev = devAddrBase(FLASHINT, passedUpSupportStruct->sup_asid - 1);
+		savedExcState->s_v0 = flashDev->d_data1;
+		return;
+	}
+	savedExcState->s_v0 = SYSCALL(GETPROCSTAT, savedExcState->s_a1, 0, 0);
+}
+
+/**********************************************************
+ *  SET_SHARE
+ *
+ *  Sets the stride scheduling tickets of the requesting
+ *  U-proc through the Nucleus SETTICKETS. Load control
+ *  suspends the U-procs with the fewest tickets first.
+ *  a1 – tickets, 1 to STRIDE_MAX_TICKETS
+ *  v0 – previous tickets, -1 if out of range
+ *
+ *  Parameters:
+ *         support_t *passedUpSupportStruct – pointer to the support struct
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void SET_SHARE(support_t *passedUpSupportStruct) {
+	state_t *savedExcState = &(passedUpSupportStruct->sup_exceptState[GENERALEXCEPT]);
+	savedExcState->s_v0 = SYSCALL(SETTICKETS, savedExcState->s_a1, 0, 0);
+
+	/* the tickets are also the priority load control suspends by */
+	if(savedExcState->s_v0 != -1) {
+		load_set_tickets(passedUpSupportStruct->sup_asid, savedExcState->s_a1);
+	}
+}
+
+/**********************************************************
+ *  TRACE_DUMP
+ *
+ *  Prints the events traced since the last dump to the
+ *  requesting U-proc's printer, oldest first, one per line:
+ *  "seq tod cpu kind asid arg0 arg1 arg2". A first line
+ *  starting with '#' gives the number of events lost to the
+ *  ring buffer wrapping. The events are copied out before
+ *  printing, since the printing is traced too. The copy
+ *  races with the writers: it stops at the first event still
+ *  being written, left for the next dump, and drops the
+ *  events whose slot was claimed again while copying.
+ *  v0 – number of events printed
+ *
+ *  Parameters:
+ *         support_t *passedUpSupportStruct – pointer to the support struct
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void TRACE_DUMP(support_t *passedUpSupportStruct) {
+	state_t *savedExcState = &(passedUpSupportStruct->sup_exceptState[GENERALEXCEPT]);
+	int devNo = passedUpSupportStruct->sup_asid - 1;
+	unsigned int seq, end, lost, first;
+	int count, i, j, len;
+	char line[96];
+	traceEvent_t *event;
+
+	SYSCALL(PASSERN, &traceDumpSem, 0, 0);
+
+	end = traceNext;
+	seq = traceDrained;
+	lost = 0;
+	if(end - seq > TRACE_ENTRIES) {
+		lost = end - TRACE_ENTRIES - seq;
+		seq = end - TRACE_ENTRIES;
+	}
+	for(i = 0; seq + i != end; i++) {
+		event = &(traceBuf[(seq + i) & (TRACE_ENTRIES - 1)]);
+		traceSnapshot[i].e_tod = event->e_tod;
+		traceSnapshot[i].e_kind = event->e_kind;
+		traceSnapshot[i].e_cpu = event->e_cpu;
+		traceSnapshot[i].e_asid = event->e_asid;
+		for(j = 0; j < 3; j++) {
+			traceSnapshot[i].e_arg[j] = event->e_arg[j];
+		}
+		/* stamped after the fields: not ours if still being written, or already overwritten */
+		traceSnapshot[i].e_seq = event->e_seq;
+		if(traceSnapshot[i].e_seq != seq + i + 1) {
+			break;
+		}
+	}
+	count = i;
+	traceDrained = seq + count;
+
+	/* a slot claimed again during the copy may hold a torn event */
+	first = 0;
+	end = traceNext;
+	if(end - seq > TRACE_ENTRIES) {
+		first = end - TRACE_ENTRIES - seq;
+		if(first > count) {
+			first = count;
+		}
+		lost += first;
+	}
+
+	len = helper_append(line, 0, "# trace lost ");
+	len += helper_num_to_str(lost, &line[len]);
+	len = helper_append(line, len, "\n");
+	helper_print_kernel_string(devNo, line, len);
+
+	for(i = first; i < count; i++) {
+		event = &(traceSnapshot[i]);
+		len = helper_num_to_str(seq + i, line);
+		len = helper_append(line, len, " ");
+		len += helper_num_to_str(event->e_tod, &line[len]);
+		len = helper_append(line, len, " ");
+		len += helper_num_to_str(event->e_cpu, &line[len]);
+		len = helper_append(line, len, " ");
+		len += helper_num_to_str(event->e_kind, &line[len]);
+		len = helper_append(line, len, " ");
+		len += helper_num_to_str(event->e_asid, &line[len]);
+		for(j = 0; j < 3; j++) {
+			len = helper_append(line, len, " ");
+			len += helper_num_to_str(event->e_arg[j], &line[len]);
+		}
+		len = helper_append(line, len, "\n");
+		helper_print_kernel_string(devNo, line, len);
+	}
+
+	SYSCALL(VERHO, &traceDumpSem, 0, 0);
+	savedExcState->s_v0 = count - first;
+}
+
+/**********************************************************
+ *  helper_prof_dump
+ *
+ *  Prints the PC histograms with samples to a printer. Each
+ *  histogram starts with "# asid A outside N", N counting
+ *  the samples past its last bucket, followed by one line
+ *  "A pc count" per non-empty bucket, pc being the bucket's
+ *  first address.
+ *
+ *  Parameters:
+ *         int devNo – printer device number
+ *
+ *  Returns:
+ *         int – number of samples printed
+ **********************************************************/
+HIDDEN int helper_prof_dump(int devNo) {
+	int asid, bucket, len;
+	unsigned int total, count;
+	char line[48];
+
+	total = 0;
+	for(asid = 0; asid <= MAXUPROC; asid++) {
+		count = profOther[asid];
+		for(bucket = 0; bucket < PROF_BUCKETS; bucket++) {
+			count += profHist[asid][bucket];
+		}
+		if(count == 0) {
+			continue;
+		}
+		total += count;
+
+		len = helper_append(line, 0, "# asid ");
+		len += helper_num_to_str(asid, &line[len]);
+		len = helper_append(line, len, " outside ");
+		len += helper_num_to_str(profOther[asid], &line[len]);
+		len = helper_append(line, len, "\n");
+		helper_print_kernel_string(devNo, line, len);
+
+		for(bucket = 0; bucket < PROF_BUCKETS; bucket++) {
+			count = profHist[asid][bucket];
+			if(count == 0) {
+				continue;
+			}
+			len = helper_num_to_str(asid, line);
+			len = helper_append(line, len, " ");
+			len += helper_num_to_str(prof_base(asid) + (bucket << PROF_SHIFT), &line[len]);
+			len = helper_append(line, len, " ");
+			len += helper_num_to_str(count, &line[len]);
+			len = helper_append(line, len, "\n");
+			helper_print_kernel_string(devNo, line, len);
+		}
+	}
+	return total;
+}
+
+/**********************************************************
+ *  PROFILE
+ *
+ *  Controls the sampling profiler (phase2/prof.c).
+ *  a1 – PROF_START: clears the histograms and samples every
+ *       a2 us (0 to sample on time slice ends only);
+ *       PROF_STOP: stops sampling;
+ *       PROF_DUMP: prints the histograms to the requesting
+ *       U-proc's printer, stop first for a consistent dump
+ *  v0 – samples printed for PROF_DUMP, 0 otherwise, -1 for
+ *       an unknown request
+ *
+ *  Parameters:
+ *         support_t *passedUpSupportStruct – pointer to the support struct
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void PROFILE_CTL(support_t *passedUpSupportStruct) {
+	state_t *savedExcState = &(passedUpSupportStruct->sup_exceptState[GENERALEXCEPT]);
+	int result = 0;
+
+	SYSCALL(PASSERN, &profSem, 0, 0);
+	switch(savedExcState->s_a1) {
+		case PROF_START:
+			prof_start(savedExcState->s_a2);
+			break;
+		case PROF_STOP:
+			prof_stop();
+			break;
+		case PROF_DUMP:
+			result = helper_prof_dump(passedUpSupportStruct->sup_asid - 1);
+			break;
+		default:
+			result = -1;
+	}
+	SYSCALL(VERHO, &profSem, 0, 0);
+	savedExcState->s_v0 = result;
+}
+
+/**********************************************************
+ *  initForkTable
+ *
+ *  Marks every forked U-proc support structure free and
+ *  every ASID as started by test(), with no children.
+ *
+ *  Parameters:
+ *
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void initForkTable() {
 	int i;
-	/* mark all of the frames it occupied as unoccupied */
-	SYSCALL(PASSERN, &swapPoolSema4, 0, 0);
-	for(i = 0; i < SWAP_POOL_SIZE; i++) {
-		if(swapPoolTable[i].ASID == passedUpSupportStruct->sup_asid) {
-			swapPoolTable[i].ASID = -1;
-			swapPoolTable[i].VPN = -1;
-			swapPoolTable[i].matchingPgTableEntry = NULL;
+	for(i = 0; i < FORK_MAX; i++) {
+		forkAsid[i] = 0;
+	}
+	for(i = 0; i <= MAXUPROC; i++) {
+		forkParent[i] = 0;
+		forkChildren[i] = 0;
+		forkExitSem[i] = 0;
+	}
+}
+
+/**********************************************************
+ *  FORK_UPROC
+ *
+ *  Creates a copy of the calling U-proc (FORK). The child
+ *  gets the first ASID above UPROC_NUM no U-proc uses, a
+ *  support structure from the fork pool and a copy-on-write
+ *  copy of the caller's address space (clone_pgTable()), and
+ *  resumes from the same SYSCALL with the same registers.
+ *  Its devices are the ones of its ASID.
+ *  v0 – the child's ASID for the caller, 0 for the child,
+ *       -1 if no ASID, support structure or page table is left
+ *
+ *  Parameters:
+ *         support_t *passedUpSupportStruct – pointer to the support struct
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void FORK_UPROC(support_t *passedUpSupportStruct) {
+	state_t *savedExcState = &(passedUpSupportStruct->sup_exceptState[GENERALEXCEPT]);
+	state_t childState;
+	support_t *childSupport;
+	int asid, i, k;
+
+	savedExcState->s_v0 = -1;
+	SYSCALL(PASSERN, &forkSem, 0, 0);
+	for(k = 0; k < FORK_MAX && forkAsid[k] != 0; k++) {
+		;
+	}
+	for(asid = UPROC_NUM + 1; asid <= MAXUPROC; asid++) {
+		for(i = 0; i < FORK_MAX && forkAsid[i] != asid; i++) {
+			;
+		}
+		if(i == FORK_MAX) {
+			break;
 		}
 	}
-	SYSCALL(VERHO, &swapPoolSema4, 0, 0);
+	if(k == FORK_MAX || asid > MAXUPROC) {
+		SYSCALL(VERHO, &forkSem, 0, 0);
+		return;
+	}
 
-	/* Mark pages as invalid (clear VALID bit) */
-	for(i = 0; i < PAGE_TABLE_SIZE; i++) {
-		passedUpSupportStruct->sup_privatePgTbl[i].EntryLo &= ~(PFN_MASK + VBITON);
+	childSupport = &(forkSupport[k]);
+	init_Uproc_support(childSupport, asid);
+	if(clone_pgTable(passedUpSupportStruct, childSupport) == FALSE) {
+		SYSCALL(VERHO, &forkSem, 0, 0);
+		return;
 	}
 
+	/* the child returns from the same SYSCALL, with 0 */
+	deep_copy_state_t(&childState, savedExcState);
+	childState.s_pc += 4;
+	childState.s_v0 = 0;
+	childState.s_entryHI = (asid << ASID_SHIFT);
+
+	open_msg_box(asid);
+	if(SYSCALL(CREATETHREAD, &childState, childSupport, 0) == -1) {
+		free_swap_frames(childSupport);
+		SYSCALL(VERHO, &forkSem, 0, 0);
+		return;
+	}
+	forkAsid[k] = asid;
+	forkParent[asid] = passedUpSupportStruct->sup_asid;
+	forkChildren[passedUpSupportStruct->sup_asid]++;
+	SYSCALL(VERHO, &forkSem, 0, 0);
+	savedExcState->s_v0 = asid;
+}
+
+/**********************************************************
+ *  TERMINATE
+ *
+ *  Terminates a user process. Waits for the U-procs it
+ *  forked to end, prints its latency summary, releases its
+ *  occupied frames and page tables, and performs SYS2 to
+ *  kill the process. A forked U-proc tells its parent instead
+ *  of test() and gives its ASID and support structure back
+ *  itself, so that a parent that lives on can fork again; as
+ *  it still runs on that stack, it goes on to SYS2 with
+ *  interrupts disabled.
+ *
+ *  Parameters:
+ *         support_t *passedUpSupportStruct – pointer to the support struct
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void TERMINATE(support_t *passedUpSupportStruct) {
+	int asid = passedUpSupportStruct->sup_asid;
+	int k, parent;
+
+	/* senders must not wait for a receiver that is gone: its children may be sending to it */
+	close_msg_box(asid);
+
+	/* SYS2 kills the progeny too: let the forked children finish first */
+	for(; forkChildren[asid] > 0; forkChildren[asid]--) {
+		SYSCALL(PASSERN, &(forkExitSem[asid]), 0, 0);
+	}
+
+	/* report where its time went while devices can still be used */
+	print_latency_summary(passedUpSupportStruct);
+	load_exit(asid);
+
+	/* Disable interrupts before touching shared structures */
+	setSTATUS(getSTATUS() & (~IECBITON));
+	/* release its frames, swap slots and page tables */
+	free_swap_frames(passedUpSupportStruct);
+
 	/* Re-enable interrupts */
 	setSTATUS(getSTATUS() | IECBITON);
 
-	SYSCALL(VERHO, &masterSemaphore, 0, 0);
+	if(forkParent[asid] == 0) {
+		SYSCALL(VERHO, &masterSemaphore, 0, 0);
+	} else {
+		SYSCALL(PASSERN, &forkSem, 0, 0);
+		for(k = 0; forkAsid[k] != asid; k++) {
+			;
+		}
+		forkAsid[k] = 0;
+		parent = forkParent[asid];
+		forkParent[asid] = 0;
+		SYSCALL(VERHO, &(forkExitSem[parent]), 0, 0);
+		/* the support struct is free from here on: no preemption on the way to SYS2 */
+		setSTATUS(getSTATUS() & (~IECBITON));
+		SYSCALL(VERHO, &forkSem, 0, 0);
+	}
 
 	/* Terminate the process */
 	SYSCALL(TERMINATETHREAD, 0, 0, 0); /* SYS2 */
@@ -158,7 +780,6 @@ void WRITE_TO_PRINTER(support_t *passedUpSupportStruct) {
 	state_t *savedExcState = &(passedUpSupportStruct->sup_exceptState[GENERALEXCEPT]);
 
 	int devNo = passedUpSupportStruct->sup_asid - 1;
-	device_t *printerDevAdd = devAddrBase(PRNTINT, devNo);
 
 	/* Error: to write to a printer device from an address outside of the requesting U-proc’s logical address space*/
 	/* Error: length less than 0*/
@@ -173,11 +794,7 @@ void WRITE_TO_PRINTER(support_t *passedUpSupportStruct) {
 	int i;
 	int devStatus;
 	for(i = 0; i < savedExcState->s_a2; i++) {
-		setSTATUS(getSTATUS() & (~IECBITON));
-		printerDevAdd->d_data0 = *(((char *)savedExcState->s_a1) + i); /*calculate address and accessing the current char*/
-		printerDevAdd->d_command = PRINTCHR;
-		devStatus = SYSCALL(IOWAIT, PRNTINT, devNo, 0); /*call SYSCALL IOWAIT to block until interrupt*/
-		setSTATUS(getSTATUS() | IECBITON);
+		devStatus = SYSCALL(DOIO, doioDev(PRNTINT, devNo, FALSE), PRINTCHR, *(((char *)savedExcState->s_a1) + i)); /*print the current char, block until interrupt*/
 		if(devStatus != READY) { /* operation ends with a status other than "Device Ready" -- this is printer, not terminal */
 			savedExcState->s_v0 = -devStatus;
 			break;
@@ -213,7 +830,6 @@ void WRITE_TO_TERMINAL(support_t *passedUpSupportStruct) {
 	state_t *savedExcState = &(passedUpSupportStruct->sup_exceptState[GENERALEXCEPT]);
 
 	int devNo = passedUpSupportStruct->sup_asid - 1;
-	device_t *termDevAdd = devAddrBase(TERMINT, devNo);
 
 	/* Error: to write to a printer device from an address outside of the requesting U-proc’s logical address space*/
 	/* Error: length less than 0*/
@@ -227,10 +843,7 @@ void WRITE_TO_TERMINAL(support_t *passedUpSupportStruct) {
 	int i;
 	int transmStatus;
 	for(i = 0; i < savedExcState->s_a2; i++) {
-		setSTATUS(getSTATUS() & (~IECBITON));
-		termDevAdd->t_transm_command = (*(((char *)savedExcState->s_a1) + i) << TRANS_COMMAND_SHIFT) + TRANSMIT_COMMAND;
-		transmStatus = SYSCALL(IOWAIT, TERMINT, devNo, FALSE); /*call SYSCALL IOWAIT to block until interrupt*/
-		setSTATUS(getSTATUS() | IECBITON);
+		transmStatus = SYSCALL(DOIO, doioDev(TERMINT, devNo, FALSE), (*(((char *)savedExcState->s_a1) + i) << TRANS_COMMAND_SHIFT) + TRANSMIT_COMMAND, 0); /*transmit the current char, block until interrupt*/
 		if((transmStatus & STATUS_CHAR_MASK) != CHAR_TRANSMITTED) { /* operation ends with a status other than Character Transmitted */
 			savedExcState->s_v0 = -transmStatus;
 			break;
@@ -263,7 +876,6 @@ void READ_FROM_TERMINAL(support_t *passedUpSupportStruct) {
 	state_t *savedExcState = &(passedUpSupportStruct->sup_exceptState[GENERALEXCEPT]);
 
 	int devNo = passedUpSupportStruct->sup_asid - 1;
-	device_t *termDevAdd = devAddrBase(TERMINT, devNo);
 
 	/* Error: to write to a printer device from an address outside of the requesting U-proc’s logical address space*/
 	/* Error: length less than 0*/
@@ -282,10 +894,7 @@ void READ_FROM_TERMINAL(support_t *passedUpSupportStruct) {
 	int recvStatus;
 	char recvChar = 'a';
 	while(recvChar != NEW_LINE) {
-		setSTATUS(getSTATUS() & (~IECBITON));
-		termDevAdd->t_recv_command = RECEIVE_COMMAND;
-		recvStatusField = SYSCALL(IOWAIT, TERMINT, devNo, TRUE); /*call SYSCALL IOWAIT to block until interrupt*/
-		setSTATUS(getSTATUS() | IECBITON);
+		recvStatusField = SYSCALL(DOIO, doioDev(TERMINT, devNo, TRUE), RECEIVE_COMMAND, 0); /*block until a char is received*/
 		recvChar = (recvStatusField & RECEIVE_CHAR_MASK) >> RECEIVE_COMMAND_SHIFT;
 		recvStatus = recvStatusField & STATUS_CHAR_MASK;
 		stringAdd[i] = recvChar; /* write the char into the string buffer array */
@@ -307,7 +916,11 @@ void READ_FROM_TERMINAL(support_t *passedUpSupportStruct) {
 /**********************************************************
  *  syscall_handler
  *
- *  Dispatches system calls from user processes. Handles SYS9 to SYS13.
+ *  Dispatches system calls from user processes. Handles SYS9 to SYS18,
+ *  SYS21/SYS22 for message passing, SYS23 for latency histograms and
+ *  SYS24/SYS25 for the EDF scheduling class, SYS26 for stride tickets,
+ *  SYS27 to dump the event trace, SYS28 for the profiler and SYS29 to
+ *  fork.
  *  If an unknown system call is encountered, invokes the trap handler.
  *
  *  Parameters:
@@ -346,6 +959,33 @@ void syscall_handler(support_t *passedUpSupportStruct) {
 			helper_return_control(passedUpSupportStruct);
 		case 18:
 			DELAY(passedUpSupportStruct);
+		case SENDMSG:
+			SEND_MSG(passedUpSupportStruct);
+			helper_return_control(passedUpSupportStruct);
+		case RECVMSG:
+			RECV_MSG(passedUpSupportStruct);
+			helper_return_control(passedUpSupportStruct);
+		case GETLATENCY:
+			GET_LATENCY(passedUpSupportStruct);
+			helper_return_control(passedUpSupportStruct);
+		case SETREALTIME:
+			SET_REAL_TIME(passedUpSupportStruct);
+			helper_return_control(passedUpSupportStruct);
+		case GETSCHEDSTAT:
+			GET_SCHED_STAT(passedUpSupportStruct);
+			helper_return_control(passedUpSupportStruct);
+		case SETSHARE:
+			SET_SHARE(passedUpSupportStruct);
+			helper_return_control(passedUpSupportStruct);
+		case TRACEDUMP:
+			TRACE_DUMP(passedUpSupportStruct);
+			helper_return_control(passedUpSupportStruct);
+		case PROFILE:
+			PROFILE_CTL(passedUpSupportStruct);
+			helper_return_control(passedUpSupportStruct);
+		case FORK:
+			FORK_UPROC(passedUpSupportStruct);
+			helper_return_control(passedUpSupportStruct);
 		default: /*the case where the process tried to do SYS 8- in user mode*/
 			program_trap_handler(passedUpSupportStruct, NULL);
 	}
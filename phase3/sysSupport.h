@@ -16,6 +16,8 @@
 #include "../h/const.h"
 
 void general_exception_handler();
+void initForkTable();
 void program_trap_handler(support_t *passedUpSupportStruct, semd_t *heldSemd);
+int helper_check_string_outside_addr_space(int strAdd);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,36 @@
+/* Interrupt burst benchmark: writes many lines to the printer, one device
+   interrupt per character. Loaded as every U-proc, the eight printers
+   complete at the same time and their interrupts pile up, so the time per
+   character shows the interrupt handling cost per device. */
+
+#include "h/localLibumps.h"
+#include "h/tconst.h"
+#include "h/print.h"
+
+#define BURSTLINES 50
+#define LINECHARS 31 /* characters in burstLine, newline included */
+
+char burstLine[] = "burstIO 0123456789 abcdefghijk\n";
+
+void main() {
+	unsigned int start, end;
+	int i;
+
+	print(WRITETERMINAL, "burstIO starts\n");
+
+	start = SYSCALL(GET_TOD, 0, 0, 0);
+	for(i = 0; i < BURSTLINES; i++) {
+		print(WRITEPRINTER, burstLine);
+	}
+	end = SYSCALL(GET_TOD, 0, 0, 0);
+
+	print(WRITETERMINAL, "burstIO: ");
+	printNum(WRITETERMINAL, BURSTLINES * LINECHARS);
+	print(WRITETERMINAL, " chars in ");
+	printNum(WRITETERMINAL, end - start);
+	print(WRITETERMINAL, " us, ");
+	printNum(WRITETERMINAL, (end - start) / (BURSTLINES * LINECHARS));
+	print(WRITETERMINAL, " us per char\n");
+
+	SYSCALL(TERMINATE, 0, 0, 0);
+}
@@ -0,0 +1,61 @@
+/* Periodic control loop in the EDF scheduling class: every PERIOD us it
+   runs a fixed amount of work, which must end within DEADLINE us of the
+   release. It then spins until the next release, so the rest of its
+   budget is used up and the Nucleus holds it until then. Prints the worst
+   lateness of a job end past its release and the deadline misses. */
+
+#include "h/localLibumps.h"
+#include "h/tconst.h"
+#include "h/print.h"
+
+#define PERIOD 20000
+#define BUDGET 4000
+#define DEADLINE 10000
+#define JOBS 100
+#define WORK 2000 /* loop iterations per job */
+
+void main() {
+	unsigned int release, now, lateness, maxLateness;
+	int job, i, sum;
+
+	print(WRITETERMINAL, "edfLoop starts\n");
+
+	/* a budget above the deadline can never be met */
+	if(SYSCALL(SETREALTIME, PERIOD, DEADLINE + 1, DEADLINE) != -1) {
+		print(WRITETERMINAL, "edfLoop: invalid reservation admitted\n");
+	}
+
+	if(SYSCALL(SETREALTIME, PERIOD, BUDGET, DEADLINE) != 0) {
+		print(WRITETERMINAL, "edfLoop: rejected, running round-robin\n");
+	}
+
+	maxLateness = 0;
+	release = SYSCALL(GET_TOD, 0, 0, 0);
+	for(job = 0; job < JOBS; job++) {
+		sum = 0;
+		for(i = 0; i < WORK; i++) {
+			sum += i;
+		}
+
+		lateness = SYSCALL(GET_TOD, 0, 0, 0) - release;
+		if(lateness > maxLateness) {
+			maxLateness = lateness;
+		}
+
+		/* wait for the next release */
+		release += PERIOD;
+		do {
+			now = SYSCALL(GET_TOD, 0, 0, 0);
+		} while(now < release);
+	}
+
+	print(WRITETERMINAL, "edfLoop: worst job end ");
+	printNum(WRITETERMINAL, maxLateness);
+	print(WRITETERMINAL, " us after release, deadline ");
+	printNum(WRITETERMINAL, DEADLINE);
+	print(WRITETERMINAL, " us, misses ");
+	printNum(WRITETERMINAL, SYSCALL(GETSCHEDSTAT, PSTAT_DLMISSES, 0, 0));
+	print(WRITETERMINAL, "\n");
+
+	SYSCALL(TERMINATE, 0, 0, 0);
+}
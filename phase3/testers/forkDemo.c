@@ -0,0 +1,73 @@
+/* Copy-on-write fork test: fills some pages, forks (SYS29), then parent
+   and child both write to the same pages. The child checks that it still
+   sees the values from before the fork and sends the number of wrong
+   words to the parent, which checks that the child's writes did not reach
+   its own pages. It also prints how long FORK took. */
+
+#include "h/localLibumps.h"
+#include "h/tconst.h"
+#include "h/print.h"
+
+#define WSBASE (SEG2 + 0x00100000) /* far from the image and the stack */
+#define PAGES 16
+#define WORDS (PAGES * PAGESIZE / WORDLEN)
+
+int countWrong(int *ws, int base) {
+	int i, wrong = 0;
+	for(i = 0; i < WORDS; i++) {
+		if(ws[i] != base + i) {
+			wrong++;
+		}
+	}
+	return wrong;
+}
+
+void fill(int *ws, int base) {
+	int i;
+	for(i = 0; i < WORDS; i++) {
+		ws[i] = base + i;
+	}
+}
+
+void main() {
+	int *ws = (int *)WSBASE;
+	unsigned int start, end;
+	int parent, child, wrong, sender;
+
+	print(WRITETERMINAL, "forkDemo starts\n");
+	fill(ws, 1000);
+	parent = SYSCALL(GETSCHEDSTAT, PSTAT_ASID, 0, 0);
+
+	start = SYSCALL(GET_TOD, 0, 0, 0);
+	child = SYSCALL(FORK, 0, 0, 0);
+	end = SYSCALL(GET_TOD, 0, 0, 0);
+
+	if(child == 0) {
+		/* the parent is writing too: this must still be the old copy */
+		wrong = countWrong(ws, 1000);
+		fill(ws, 5000);
+		wrong += countWrong(ws, 5000);
+		SYSCALL(SENDMSG, parent, wrong, 0);
+		SYSCALL(TERMINATE, 0, 0, 0);
+	}
+	if(child == -1) {
+		print(WRITETERMINAL, "forkDemo error: FORK failed\n");
+		SYSCALL(TERMINATE, 0, 0, 0);
+	}
+
+	print(WRITETERMINAL, "forkDemo: FORK took ");
+	printNum(WRITETERMINAL, end - start);
+	print(WRITETERMINAL, " us\n");
+
+	fill(ws, 9000);
+	wrong = SYSCALL(RECVMSG, 0, (int)&sender, 0);
+	if(wrong != 0 || sender != child) {
+		print(WRITETERMINAL, "forkDemo error: the child saw the parent's writes\n");
+	} else if(countWrong(ws, 9000) != 0) {
+		print(WRITETERMINAL, "forkDemo error: the parent saw the child's writes\n");
+	} else {
+		print(WRITETERMINAL, "forkDemo ok: parent and child pages are private\n");
+	}
+
+	SYSCALL(TERMINATE, 0, 0, 0);
+}
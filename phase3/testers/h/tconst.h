@@ -30,6 +30,24 @@
 #define DELAY 18
 #define PSEMVIRT 19
 #define VSEMVIRT 20
+#define SENDMSG 21
+#define RECVMSG 22
+#define GETLATENCY 23
+#define SETREALTIME 24
+#define GETSCHEDSTAT 25
+#define SETSHARE 26
+#define TRACEDUMP 27
+#define PROFILE 28
+#define FORK 29
+#define PROF_START 0
+#define PROF_STOP 1
+#define PROF_DUMP 2
+#define PSTAT_DLMISSES 0
+#define PSTAT_CPUTIME 1
+#define PSTAT_SWITCHES 2
+#define PSTAT_QUANTUM 3
+#define PSTAT_ASID 4
+#define PSTAT_FLASHBLOCKS 5
 
 #define SEG0 0x00000000
 #define SEG1 0x40000000
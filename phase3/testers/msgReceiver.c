@@ -0,0 +1,47 @@
+/* Tests message passing: receives the words and the page sent by msgSender */
+
+#include "h/localLibumps.h"
+#include "h/tconst.h"
+#include "h/print.h"
+
+#define MSGCOUNT 5
+
+void main() {
+	int i, word, sender;
+	int corrupt;
+	int *page;
+
+	print(WRITETERMINAL, "msgReceiver starts\n");
+
+	corrupt = FALSE;
+	for(i = 0; i < MSGCOUNT; i++) {
+		word = SYSCALL(RECVMSG, 0, (int)&sender, 0);
+		if(word != i) {
+			corrupt = TRUE;
+		}
+	}
+
+	if(corrupt == FALSE)
+		print(WRITETERMINAL, "msgReceiver ok: words in order\n");
+	else
+		print(WRITETERMINAL, "msgReceiver error: words out of order\n");
+
+	/* receive the page somewhere else in our own address space */
+	page = (int *)(SEG2 + (25 * PAGESIZE));
+	word = SYSCALL(RECVMSG, (int)page, (int)&sender, 0);
+
+	corrupt = (word != MSGCOUNT);
+	for(i = 0; i < PAGESIZE / WORDLEN; i++) {
+		if(page[i] != i) {
+			corrupt = TRUE;
+			break;
+		}
+	}
+
+	if(corrupt == FALSE)
+		print(WRITETERMINAL, "msgReceiver ok: page survived remap\n");
+	else
+		print(WRITETERMINAL, "msgReceiver error: page corrupted\n");
+
+	SYSCALL(TERMINATE, 0, 0, 0);
+}
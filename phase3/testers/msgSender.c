@@ -0,0 +1,33 @@
+/* Tests message passing: sends words and a page to msgReceiver */
+
+#include "h/localLibumps.h"
+#include "h/tconst.h"
+#include "h/print.h"
+
+#define RECEIVER_ASID 2
+#define MSGCOUNT 5
+
+void main() {
+	int i;
+	int *page;
+
+	print(WRITETERMINAL, "msgSender starts\n");
+
+	/* register sized messages */
+	for(i = 0; i < MSGCOUNT; i++) {
+		SYSCALL(SENDMSG, RECEIVER_ASID, i, 0);
+	}
+
+	print(WRITETERMINAL, "msgSender ok: sent words\n");
+
+	/* fill a page and hand it over */
+	page = (int *)(SEG2 + (20 * PAGESIZE));
+	for(i = 0; i < PAGESIZE / WORDLEN; i++) {
+		page[i] = i;
+	}
+	SYSCALL(SENDMSG, RECEIVER_ASID, MSGCOUNT, (int)page);
+
+	print(WRITETERMINAL, "msgSender ok: sent page\n");
+
+	SYSCALL(TERMINATE, 0, 0, 0);
+}
@@ -17,3 +17,19 @@ void print(int device, char *str) {
 		SYSCALL(TERMINATE, 0, 0, 0);
 	}
 }
+
+/* Function to print an unsigned number in decimal to a terminal or printer device */
+void printNum(int device, unsigned int num) {
+	char buf[11];
+	int i;
+
+	i = 10;
+	buf[i] = EOS;
+	do {
+		i--;
+		buf[i] = '0' + (num % 10);
+		num = num / 10;
+	} while(num != 0);
+
+	print(device, &buf[i]);
+}
@@ -0,0 +1,46 @@
+/* Sampling profiler test: profiles a recursive fib and a cheaper loop
+   (SYS28), then dumps the PC histograms to its printer. Symbolize the
+   printer output with tools/profsym: fib should get most of the samples,
+   sumLoop a small share. */
+
+#include "h/localLibumps.h"
+#include "h/tconst.h"
+#include "h/print.h"
+
+#define PERIOD 500 /* us between samples */
+
+int fib(int n) {
+	if(n < 2) {
+		return n;
+	}
+	return fib(n - 1) + fib(n - 2);
+}
+
+int sumLoop(int n) {
+	int i, sum = 0;
+	for(i = 0; i < n; i++) {
+		sum += i ^ (sum >> 3);
+	}
+	return sum;
+}
+
+void main() {
+	int i, samples;
+
+	print(WRITETERMINAL, "profileDemo starts\n");
+
+	SYSCALL(PROFILE, PROF_START, PERIOD, 0);
+	for(i = 0; i < 3; i++) {
+		fib(18);
+	}
+	sumLoop(10000);
+	SYSCALL(PROFILE, PROF_STOP, 0, 0);
+
+	samples = SYSCALL(PROFILE, PROF_DUMP, 0, 0);
+
+	print(WRITETERMINAL, "profileDemo: ");
+	printNum(WRITETERMINAL, samples);
+	print(WRITETERMINAL, " samples printed\n");
+
+	SYSCALL(TERMINATE, 0, 0, 0);
+}
@@ -0,0 +1,41 @@
+/* Tests sparse address spaces: pages far apart in kuseg each need their own page table */
+
+#include "h/localLibumps.h"
+#include "h/tconst.h"
+#include "h/print.h"
+
+#define RANGES 8
+#define RANGESTRIDE (64 * PAGESIZE) /* two second-level page tables apart */
+
+void main() {
+	int i;
+	int corrupt;
+
+	print(WRITETERMINAL, "sparseVM starts\n");
+
+	/* write into the first word of a page in each far away range */
+	for(i = 1; i <= RANGES; i++) {
+		*(int *)(SEG2 + (i * RANGESTRIDE)) = i;
+	}
+	/* and one in the middle of kuseg */
+	*(int *)(SEG2 + 0x20000000) = 42;
+
+	print(WRITETERMINAL, "sparseVM ok: wrote to sparse pages\n");
+
+	corrupt = FALSE;
+	for(i = 1; i <= RANGES; i++) {
+		if(*(int *)(SEG2 + (i * RANGESTRIDE)) != i) {
+			corrupt = TRUE;
+		}
+	}
+	if(*(int *)(SEG2 + 0x20000000) != 42) {
+		corrupt = TRUE;
+	}
+
+	if(corrupt == FALSE)
+		print(WRITETERMINAL, "sparseVM ok: data survived swapper\n");
+	else
+		print(WRITETERMINAL, "sparseVM error: swapper corrupted data\n");
+
+	SYSCALL(TERMINATE, 0, 0, 0);
+}
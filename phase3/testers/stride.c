@@ -0,0 +1,48 @@
+/* Stride scheduling share test: takes TICKETS tickets and computes for
+   ROUNDS seconds, printing after each one the CPU time it got so far in
+   per-mille of the wall time. The Makefile builds it twice,
+   strideHeavy with 300 tickets and strideLight with 100: loaded next to
+   each other the shares converge to the ratio of the tickets (3:1). */
+
+#include "h/localLibumps.h"
+#include "h/tconst.h"
+#include "h/print.h"
+
+#ifndef TICKETS
+#define TICKETS 100
+#endif
+#ifndef NAME
+#define NAME "stride"
+#endif
+#define ROUNDS 5
+
+void main() {
+	unsigned int start, now, cpu;
+	int round, sum;
+
+	print(WRITETERMINAL, NAME " starts\n");
+
+	if(SYSCALL(SETSHARE, TICKETS, 0, 0) == -1) {
+		print(WRITETERMINAL, NAME ": tickets rejected\n");
+	}
+
+	start = SYSCALL(GET_TOD, 0, 0, 0);
+	sum = 0;
+	for(round = 1; round <= ROUNDS; round++) {
+		do {
+			sum++;
+			now = SYSCALL(GET_TOD, 0, 0, 0);
+		} while(now - start < round * SECOND);
+
+		cpu = SYSCALL(GETSCHEDSTAT, PSTAT_CPUTIME, 0, 0);
+		print(WRITETERMINAL, NAME ": ");
+		printNum(WRITETERMINAL, TICKETS);
+		print(WRITETERMINAL, " tickets, cpu share ");
+		printNum(WRITETERMINAL, cpu / ((now - start) / 1000));
+		print(WRITETERMINAL, " per-mille after ");
+		printNum(WRITETERMINAL, round);
+		print(WRITETERMINAL, " s\n");
+	}
+
+	SYSCALL(TERMINATE, 0, 0, 0);
+}
@@ -0,0 +1,74 @@
+/* Microbenchmark of the Nucleus syscall fast paths, as far as a U-proc
+   can reach them. A U-proc cannot issue SYS1-SYS8 itself, so three
+   Support Level calls are timed and subtracted:
+   - SYS10 (GET_TOD): exception entry, pass up, the support level's SYS8
+     and the return, with no other Nucleus call;
+   - SYS25 (GETSCHEDSTAT): the same plus one non-blocking Nucleus call
+     (GETPROCSTAT), dispatched from the table with no state copy;
+   - SYS26 (SETSHARE): the same plus SETTICKETS and a P/V pair of the free
+     load control mutex, the SYS3/SYS4 path that never blocks.
+   It prints the SYS10 round trip, the Nucleus call (SYS25 less SYS10) and
+   the P/V pair (SYS26 less SYS25) in ns. The kernel-mode figures of the
+   same paths are in phase2/p2bench.c. */
+
+#include "h/localLibumps.h"
+#include "h/tconst.h"
+#include "h/print.h"
+
+#define ROUNDS 5000
+
+/* ns per call of ROUNDS calls taking total us, without overflowing */
+unsigned int nsPerCall(unsigned int total) {
+	return (total / ROUNDS) * 1000 + ((total % ROUNDS) * 1000) / ROUNDS;
+}
+
+/* a - b, or 0 when the difference is lost in the noise */
+unsigned int nsDiff(unsigned int a, unsigned int b) {
+	if(a < b) {
+		return 0;
+	}
+	return a - b;
+}
+
+void main() {
+	unsigned int start, end, passUp, nucleusCall, semPair;
+	int i, tickets;
+
+	print(WRITETERMINAL, "syscallBench starts\n");
+
+	start = SYSCALL(GET_TOD, 0, 0, 0);
+	for(i = 0; i < ROUNDS; i++) {
+		SYSCALL(GET_TOD, 0, 0, 0);
+	}
+	end = SYSCALL(GET_TOD, 0, 0, 0);
+	passUp = nsPerCall(end - start);
+
+	start = SYSCALL(GET_TOD, 0, 0, 0);
+	for(i = 0; i < ROUNDS; i++) {
+		SYSCALL(GETSCHEDSTAT, PSTAT_ASID, 0, 0);
+	}
+	end = SYSCALL(GET_TOD, 0, 0, 0);
+	nucleusCall = nsPerCall(end - start);
+
+	/* set the tickets it already has, so that the scheduling is not changed */
+	tickets = SYSCALL(SETSHARE, 100, 0, 0);
+	start = SYSCALL(GET_TOD, 0, 0, 0);
+	for(i = 0; i < ROUNDS; i++) {
+		SYSCALL(SETSHARE, tickets, 0, 0);
+	}
+	end = SYSCALL(GET_TOD, 0, 0, 0);
+	semPair = nsDiff(nsPerCall(end - start), nucleusCall);
+	nucleusCall = nsDiff(nucleusCall, passUp);
+
+	print(WRITETERMINAL, "syscallBench: ");
+	printNum(WRITETERMINAL, ROUNDS);
+	print(WRITETERMINAL, " calls each, SYS10 round trip ");
+	printNum(WRITETERMINAL, passUp);
+	print(WRITETERMINAL, " ns, Nucleus call ");
+	printNum(WRITETERMINAL, nucleusCall);
+	print(WRITETERMINAL, " ns, P/V pair ");
+	printNum(WRITETERMINAL, semPair);
+	print(WRITETERMINAL, " ns\n");
+
+	SYSCALL(TERMINATE, 0, 0, 0);
+}
@@ -0,0 +1,39 @@
+/* Microbenchmark of the TLB-Refill handler: touches all 32 pages of the
+   image range in a loop. With a 16 entry TLB every touch is a refill. */
+
+#include "h/localLibumps.h"
+#include "h/tconst.h"
+#include "h/print.h"
+
+#define BENCHPAGES 32
+#define ROUNDS 1000
+
+void main() {
+	unsigned int start, end;
+	int i, p;
+	int sum;
+
+	print(WRITETERMINAL, "tlbRefillBench starts\n");
+
+	/* fault every page in first so that only refills are timed */
+	sum = 0;
+	for(p = 0; p < BENCHPAGES; p++) {
+		sum += *(int *)(SEG2 + (p * PAGESIZE));
+	}
+
+	start = SYSCALL(GET_TOD, 0, 0, 0);
+	for(i = 0; i < ROUNDS; i++) {
+		for(p = 0; p < BENCHPAGES; p++) {
+			sum += *(int *)(SEG2 + (p * PAGESIZE));
+		}
+	}
+	end = SYSCALL(GET_TOD, 0, 0, 0);
+
+	print(WRITETERMINAL, "tlbRefillBench: ");
+	printNum(WRITETERMINAL, ROUNDS * BENCHPAGES);
+	print(WRITETERMINAL, " touches in ");
+	printNum(WRITETERMINAL, end - start);
+	print(WRITETERMINAL, " us\n");
+
+	SYSCALL(TERMINATE, 0, 0, 0);
+}
@@ -0,0 +1,29 @@
+/* Event trace test: touches a few pages and writes to its terminal, so
+   the trace holds dispatches, syscalls, page faults and device I/O, then
+   dumps the trace to its printer (SYS27). Convert the printer output with
+   tools/trace2json to view it in chrome://tracing or Perfetto. */
+
+#include "h/localLibumps.h"
+#include "h/tconst.h"
+#include "h/print.h"
+
+#define PAGES 8
+
+void main() {
+	int i, events;
+
+	print(WRITETERMINAL, "traceDump starts\n");
+
+	for(i = 0; i < PAGES; i++) {
+		*(int *)(SEG2 + ((20 + i) * PAGESIZE)) = i;
+	}
+	print(WRITETERMINAL, "traceDump: pages touched\n");
+
+	events = SYSCALL(TRACEDUMP, 0, 0, 0);
+
+	print(WRITETERMINAL, "traceDump: ");
+	printNum(WRITETERMINAL, events);
+	print(WRITETERMINAL, " events printed\n");
+
+	SYSCALL(TERMINATE, 0, 0, 0);
+}
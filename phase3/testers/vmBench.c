@@ -0,0 +1,84 @@
+/* Support Level benchmarks, the U-proc side of phase2/p2bench.c: writes
+   CSV lines "bench,iterations,total_us,ns_per_op" on its printer.
+   - sys10_gettod: a syscall passed up to the Support Level and back;
+   - tlb_refill: touches of 32 resident pages, more than the TLB holds,
+     less the same number of touches of one page, per touch;
+   - page_fault: first touches of pages never used, per fault, including
+     the page outs once the swap pool is full: FAULTPAGES is more than the
+     frames of the phase3pl machine, so the pool always fills. */
+
+#include "h/localLibumps.h"
+#include "h/tconst.h"
+#include "h/print.h"
+
+#define SYSCALLS 5000
+#define BENCHPAGES 32
+#define ROUNDS 200
+#define FAULTPAGES 640 /* more pages than the 512 frames of phase3pl */
+#define FAULTBASE (SEG2 + 0x00100000) /* far from the image, never touched before */
+
+void report(char *name, unsigned int iterations, unsigned int total) {
+	print(WRITEPRINTER, name);
+	print(WRITEPRINTER, ",");
+	printNum(WRITEPRINTER, iterations);
+	print(WRITEPRINTER, ",");
+	printNum(WRITEPRINTER, total);
+	print(WRITEPRINTER, ",");
+	/* total * 1000 would overflow past 4.29 s */
+	printNum(WRITEPRINTER, (total / iterations) * 1000 + ((total % iterations) * 1000) / iterations);
+	print(WRITEPRINTER, "\n");
+}
+
+void main() {
+	unsigned int start, end, baseline;
+	int i, p;
+	int sum;
+
+	print(WRITETERMINAL, "vmBench starts\n");
+	print(WRITEPRINTER, "bench,iterations,total_us,ns_per_op\n");
+
+	start = SYSCALL(GET_TOD, 0, 0, 0);
+	for(i = 0; i < SYSCALLS; i++) {
+		SYSCALL(GET_TOD, 0, 0, 0);
+	}
+	end = SYSCALL(GET_TOD, 0, 0, 0);
+	report("sys10_gettod", SYSCALLS, end - start);
+
+	/* fault every page in first so that only refills are timed */
+	sum = 0;
+	for(p = 0; p < BENCHPAGES; p++) {
+		sum += *(int *)(SEG2 + (p * PAGESIZE));
+	}
+
+	start = SYSCALL(GET_TOD, 0, 0, 0);
+	for(i = 0; i < ROUNDS; i++) {
+		for(p = 0; p < BENCHPAGES; p++) {
+			sum += *(int *)SEG2;
+		}
+	}
+	end = SYSCALL(GET_TOD, 0, 0, 0);
+	baseline = end - start;
+
+	start = SYSCALL(GET_TOD, 0, 0, 0);
+	for(i = 0; i < ROUNDS; i++) {
+		for(p = 0; p < BENCHPAGES; p++) {
+			sum += *(int *)(SEG2 + (p * PAGESIZE));
+		}
+	}
+	end = SYSCALL(GET_TOD, 0, 0, 0);
+	if(end - start < baseline) {
+		baseline = end - start;
+	}
+	report("tlb_refill", ROUNDS * BENCHPAGES, end - start - baseline);
+
+	start = SYSCALL(GET_TOD, 0, 0, 0);
+	for(p = 0; p < FAULTPAGES; p++) {
+		*(int *)(FAULTBASE + (p * PAGESIZE)) = p;
+	}
+	end = SYSCALL(GET_TOD, 0, 0, 0);
+	report("page_fault", FAULTPAGES, end - start);
+
+	print(WRITETERMINAL, "vmBench done\n");
+
+	SYSCALL(TERMINATE, 0, 0, 0);
+}
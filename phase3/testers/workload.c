@@ -0,0 +1,211 @@
+/* Synthetic workload for pager and scheduler benchmarks. Its parameters
+   come from block WL_BLOCK of its flash device, the first one after the
+   image (write them with tools/wkldcfg; without them the defaults below
+   are used). It runs operations for the given duration, each one being
+   a CPU burst, a number of page touches following the access pattern
+   over the working set, and, every ioEvery operations, one I/O. At the
+   end it prints on its terminal the operations per second, the page
+   faults per second and the 50th, 90th and 99th percentile and maximum
+   of the operation latency. */
+
+#include "h/localLibumps.h"
+#include "h/tconst.h"
+#include "h/print.h"
+#include "../../h/const.h"
+
+/* parameter block, as in tools/wkldcfg.c */
+#define WL_MAGIC 0x444C4B57 /* "WKLD" */
+#define WL_BLOCK 32
+
+#define WL_SEQUENTIAL 0
+#define WL_RANDOM 1
+#define WL_STRIDED 2
+#define WL_HOTCOLD 3
+
+#define WL_IO_NONE 0
+#define WL_IO_DISK 1
+#define WL_IO_TERMINAL 2
+#define WL_IO_PRINTER 3
+
+typedef struct wlParams_t {
+	int magic;
+	int burst;    /* us of CPU per operation */
+	int wsPages;  /* working set, in pages */
+	int pattern;  /* WL_SEQUENTIAL ... WL_HOTCOLD */
+	int stride;   /* pages between touches, WL_STRIDED */
+	int hotPct;   /* percent of the touches to the hot tenth of the working set, WL_HOTCOLD */
+	int touches;  /* page touches per operation */
+	int ioDev;    /* WL_IO_NONE ... WL_IO_PRINTER */
+	int ioEvery;  /* operations per I/O */
+	int duration; /* ms */
+} wlParams_t;
+
+#define WSBASE (SEG2 + 0x00100000) /* far from the image and the stack */
+/* a U-proc owns up to PGDIR_SIZE - 1 page tables, one of them for the image and one for the
+   stack; WSBASE starts a table, so the working set gets all the others */
+#define WSMAXPAGES ((PGDIR_SIZE - 1 - 2) * PGTBL_LEAF_SIZE)
+#define IODISK 1                   /* disk 0 is the backing store */
+#define CALIBRATION 100000         /* loop iterations timed at start-up */
+#define LATBUCKETS 24              /* log2 buckets of us, as the Nucleus histograms */
+
+int pageBuf[PAGESIZE / WORDLEN];   /* flash block and disk sector buffer */
+int faultHist[HIST_BUCKETS];
+unsigned int latHist[LATBUCKETS];
+unsigned int seed = 12345;
+volatile int spin;
+
+unsigned int nextRandom() {
+	seed = seed * 1103515245 + 12345;
+	return (seed >> 16) & 0x7FFF;
+}
+
+/* page to touch after page prev */
+int nextPage(wlParams_t *wl, int prev) {
+	int hot;
+
+	switch(wl->pattern) {
+		case WL_SEQUENTIAL:
+			return (prev + 1) % wl->wsPages;
+		case WL_STRIDED:
+			return (prev + wl->stride) % wl->wsPages;
+		case WL_HOTCOLD:
+			hot = wl->wsPages / 10;
+			if(hot == 0) {
+				hot = 1;
+			}
+			if((int)(nextRandom() % 100) < wl->hotPct || hot == wl->wsPages) {
+				return nextRandom() % hot;
+			}
+			return hot + nextRandom() % (wl->wsPages - hot);
+		default:
+			return nextRandom() % wl->wsPages;
+	}
+}
+
+void doIo(wlParams_t *wl, int op) {
+	switch(wl->ioDev) {
+		case WL_IO_DISK:
+			pageBuf[0] = op;
+			SYSCALL(DISK_PUT, (int)pageBuf, IODISK, op % 16);
+			break;
+		case WL_IO_TERMINAL:
+			print(WRITETERMINAL, ".");
+			break;
+		case WL_IO_PRINTER:
+			print(WRITEPRINTER, ".");
+			break;
+	}
+}
+
+/* upper bound in us of the bucket holding the pct-th percentile */
+unsigned int percentile(unsigned int ops, int pct) {
+	unsigned int seen = 0;
+	int b;
+
+	for(b = 0; b < LATBUCKETS; b++) {
+		seen += latHist[b];
+		if(seen * 100 >= ops * pct) {
+			break;
+		}
+	}
+	return 1 << b;
+}
+
+void printStat(char *name, unsigned int value, char *unit) {
+	print(WRITETERMINAL, name);
+	printNum(WRITETERMINAL, value);
+	print(WRITETERMINAL, unit);
+}
+
+void main() {
+	wlParams_t wl;
+	int *stored = pageBuf;
+	unsigned int start, end, now, last, lat, loopsPerMs, ops, faults0, faults;
+	int i, t, b, page;
+
+	print(WRITETERMINAL, "workload starts\n");
+
+	wl.burst = 200;
+	wl.wsPages = 48;
+	wl.pattern = WL_RANDOM;
+	wl.stride = 1;
+	wl.hotPct = 90;
+	wl.touches = 4;
+	wl.ioDev = WL_IO_NONE;
+	wl.ioEvery = 10;
+	wl.duration = 2000;
+	/* reading past the end of the flash device would kill the U-proc */
+	stored[0] = 0;
+	if(SYSCALL(GETSCHEDSTAT, PSTAT_FLASHBLOCKS, 0, 0) > WL_BLOCK) {
+		SYSCALL(FLASH_GET, (int)pageBuf, SYSCALL(GETSCHEDSTAT, PSTAT_ASID, 0, 0) - 1, WL_BLOCK);
+	}
+	if(stored[0] == WL_MAGIC) {
+		/* word by word, the buffer is reused for the disk I/O */
+		for(i = 0; i < sizeof(wlParams_t) / WORDLEN; i++) {
+			((int *)&wl)[i] = stored[i];
+		}
+	} else {
+		print(WRITETERMINAL, "workload: no parameter block, using the defaults\n");
+	}
+	if(wl.wsPages < 1 || wl.wsPages > WSMAXPAGES) {
+		wl.wsPages = WSMAXPAGES;
+	}
+	if(wl.stride < 1) {
+		wl.stride = 1;
+	}
+	if(wl.ioEvery < 1) {
+		wl.ioEvery = 1;
+	}
+
+	/* the CPU burst is a busy loop, calibrated against the TOD clock */
+	start = SYSCALL(GET_TOD, 0, 0, 0);
+	for(spin = 0; spin < CALIBRATION; spin++) {
+		;
+	}
+	end = SYSCALL(GET_TOD, 0, 0, 0);
+	loopsPerMs = (CALIBRATION * 1000) / ((end - start) + 1);
+
+	faults0 = SYSCALL(GETLATENCY, HIST_PGFAULT, (int)faultHist, 0);
+	page = 0;
+	ops = 0;
+	start = SYSCALL(GET_TOD, 0, 0, 0);
+	last = start;
+	do {
+		for(spin = (loopsPerMs * wl.burst) / 1000; spin > 0; spin--) {
+			;
+		}
+		for(t = 0; t < wl.touches; t++) {
+			page = nextPage(&wl, page);
+			*(int *)(WSBASE + page * PAGESIZE) = ops;
+		}
+		if(wl.ioDev != WL_IO_NONE && ops % wl.ioEvery == 0) {
+			doIo(&wl, ops);
+		}
+		ops++;
+
+		now = SYSCALL(GET_TOD, 0, 0, 0);
+		lat = now - last;
+		last = now;
+		for(b = 0; b < LATBUCKETS - 1 && lat >= (1U << b); b++) {
+			;
+		}
+		latHist[b]++;
+	} while(now - start < (unsigned int)wl.duration * 1000);
+	end = now;
+	faults = SYSCALL(GETLATENCY, HIST_PGFAULT, (int)faultHist, 0) - faults0;
+
+	if(wl.ioDev != WL_IO_NONE) {
+		print(WRITETERMINAL, "\n");
+	}
+	printStat("workload: ", ops, " ops in ");
+	printStat("", (end - start) / 1000, " ms\n");
+	printStat("workload: ", (ops * 1000) / ((end - start) / 1000 + 1), " ops/s, ");
+	printStat("", faults, " page faults, ");
+	printStat("", (faults * 1000) / ((end - start) / 1000 + 1), " faults/s\n");
+	printStat("workload: latency p50 < ", percentile(ops, 50), " us, ");
+	printStat("p90 < ", percentile(ops, 90), " us, ");
+	printStat("p99 < ", percentile(ops, 99), " us, ");
+	printStat("max < ", percentile(ops, 100), " us\n");
+
+	SYSCALL(TERMINATE, 0, 0, 0);
+}
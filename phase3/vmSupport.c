@@ -4,15 +4,52 @@
  *
  *  This module implements the TLB exception handler which handles page faults
  *  for U-procs. When a page is not in memory, the Pager loads it from secondary
- *  storage (flash device).
+ *  storage: the swap devices, the disks of SWAP_DISK_MASK and the flash
+ *  devices of SWAP_FLASH_MASK. The Support Level refuses U-proc I/O to the
+ *  swap disks and to the swap blocks of the swap flash devices.
  *
- *  Because U-procs can only access flash devices for paging purposes, this
- *  module also includes functions to handle read and write operations
- *  between memory and flash storage.
+ *  The TLB of every processor is kept coherent: whenever a translation is
+ *  invalidated here, tlb_shootdown() clears the TLBs of the other processors.
  *
  *  Additionally, this module maintains:
- *  - A swap pool table that tracks which physical frames are currently in use
+ *  - A swap pool table that tracks which physical frames are currently in use.
+ *    The swap pool is every frame phys_alloc() has left once the compressed
+ *    tier and the table itself are carved out, so it grows with the RAM.
  *  - A swap pool semaphore used to ensure synchronized access to the swap pool
+ *  - A bitmap of the swap slots. Slots are numbered across the swap devices,
+ *    RESERVED_DISK_NO first, whose first SWAP_FIRST_SLOT sectors hold the
+ *    staged U-proc images. Every page records the slot holding its last paged
+ *    out copy (l_slot); a page never paged out has none and is zero filled,
+ *    unless it is part of the image. Victims are paged out in clusters of up
+ *    to SWAP_CLUSTER frames, in FIFO order, to consecutive slots of one
+ *    device: one seek per cluster instead of one per page. Each cluster goes
+ *    to the swap device with the fewest outstanding requests, round robin
+ *    among equally loaded ones.
+ *  - A compressed swap tier in RAM (ZSWAP_PAGES from zswapStart) in front of
+ *    the swap devices. A victim is first run-length encoded, word by word;
+ *    if it takes at most ZSWAP_MAX_WORDS it is kept there, its slot being
+ *    ZSWAP_SLOT plus its first chunk, and only the others are written out.
+ *    The tier is exclusive: a page faulted in from it leaves it, and a page
+ *    that finds it full goes to the swap devices.
+ *  - Sharing of image pages. set_up_backing_store() stages identical image
+ *    pages once, so U-procs running the same code fault in the same image
+ *    sectors. An image page is mapped read-only (no D bit) and the frame
+ *    remembers its sector (imageSect); a fault on the same sector by another
+ *    U-proc maps the frame too (sharers). The first write to it takes a
+ *    TLB-Modification exception and gets a private copy. Unmodified image
+ *    frames are dropped, not written, when evicted.
+ *  - Copy-on-write cloning (FORK). The child gets a copy of the parent's
+ *    page tables: every resident frame is shared, both mappings read-only,
+ *    and every swap slot is referenced by both, so slots are reference
+ *    counted (swapRefs, zswapRefs) and freed with their last reference.
+ *    The first write by either side copies the frame like an image page.
+ *  - Load control (loadSupport.c). Every fault is counted there, and a
+ *    U-proc it suspended because the pager thrashes is held at its next
+ *    fault; its frames are the first victims, so it is swapped out.
+ *  - The swap pool semaphore is released while a page is read or written, so
+ *    that faults served by different devices overlap. The frames involved are
+ *    marked in transit meanwhile: they are never victims, and a fault on a
+ *    page in transit waits for it to land.
  *
  *
  *      Modified by Phuong and Oghap on March 2025
@@ -21,253 +58,1388 @@
 #include "vmSupport.h"
 #include "initProc.h"
 #include "sysSupport.h"
+#include "loadSupport.h"
 
 #include "../phase4/devSupport.h"
 
 #include "../phase2/initial.h"
+#include "../phase2/histogram.h"
+#include "../phase2/trace.h"
+#include "../phase2/physMem.h"
 
-swapPoolFrame_t swapPoolTable[SWAP_POOL_SIZE];
+swapPoolFrame_t *swapPoolTable; /* swapPoolSize entries */
+int swapPoolSize;                /* every frame left at boot */
+memaddr swapPoolStart;
 int swapPoolSema4;
 
+HIDDEN pgTblLeaf_t leafPool[LEAF_POOL_SIZE]; /* second-level page tables */
+HIDDEN pgTblLeaf_t *leafFree_h;
+
+HIDDEN sharer_t sharerPool[SHARER_POOL_SIZE]; /* mappings of shared frames */
+HIDDEN sharer_t *sharerFree_h;
+
+HIDDEN unsigned int swapMap[SWAP_MAX_SLOTS / 32]; /* bit set: swap slot in use */
+HIDDEN unsigned char swapRefs[SWAP_MAX_SLOTS];    /* page tables referencing each slot in use */
+HIDDEN swapDev_t swapDevs[SWAP_MAX_DEVS];         /* swap devices, RESERVED_DISK_NO first */
+HIDDEN int swapDevCount;
+HIDDEN int swapNextDev;                           /* round robin among equally loaded devices */
+HIDDEN int swapTransitSema4 = 0;                  /* faults waiting for a page or a frame in transit */
+HIDDEN int swapWaiters = 0;
+
+HIDDEN memaddr zswapStart;                       /* ZSWAP_PAGES frames of the compressed tier */
+HIDDEN unsigned int zswapMap[ZSWAP_CHUNKS / 32]; /* bit set: chunk of the compressed tier in use */
+HIDDEN unsigned char zswapRefs[ZSWAP_CHUNKS];    /* page tables referencing each page, by first chunk */
+HIDDEN int zswapCursor;                          /* where the next search for free chunks starts */
+HIDDEN int zswapBuf[ZSWAP_MAX_WORDS];            /* page being compressed */
+zswapStat_t zswapStats[MAXUPROC + 1];            /* compressed tier use, by ASID */
+
 void debugCheckDskDimension(int a0, int a1, int a2, int a3){
 
 }
 
+#ifdef PANDOS_DEBUG
 void debugTLBrefill(int a0, int a1, int a2, int a3){
 
 }
+#endif
+
+/**********************************************************
+ *  initPgTblLeaves
+ *
+ *  Puts every second-level page table of the leaf pool on
+ *  the free list.
+ *
+ *  Parameters:
+ *
+ *
+ *  Returns:
+ *
+ **********************************************************/
+HIDDEN void initPgTblLeaves() {
+	int i;
+	leafFree_h = NULL;
+	for(i = LEAF_POOL_SIZE - 1; i >= 0; i--) {
+		leafPool[i].l_region = NO_REGION;
+		leafPool[i].l_next = leafFree_h;
+		leafFree_h = &(leafPool[i]);
+	}
+}
+
+/**********************************************************
+ *  add_swap_dev
+ *
+ *  Appends a device to the swap devices, with the slots from
+ *  the given sector or block up to its end (DATA1), as long
+ *  as the bitmap has room for them.
+ *
+ *  Parameters:
+ *         int line – DISKINT or FLASHINT
+ *         int devNo – device number
+ *         int first – first sector or block used for swap
+ *
+ *  Returns:
+ *
+ **********************************************************/
+HIDDEN void add_swap_dev(int line, int devNo, int first) {
+	device_t *devReg = devAddrBase(line, devNo);
+	swapDev_t *dev = &(swapDevs[swapDevCount]);
+	int size;
+
+	dev->sd_line = line;
+	dev->sd_devNo = devNo;
+	dev->sd_heads = 1;
+	dev->sd_sects = 1;
+	if(line == DISKINT) {
+		dev->sd_heads = ((devReg->d_data1) >> 8) & 0xFF;
+		dev->sd_sects = (devReg->d_data1) & 0xFF;
+		size = (((devReg->d_data1) >> 16) & 0xFFFF) * dev->sd_heads * dev->sd_sects;
+	} else {
+		size = devReg->d_data1;
+	}
+	dev->sd_first = first;
+	dev->sd_base = (swapDevCount == 0) ? 0 : swapDevs[swapDevCount - 1].sd_base + swapDevs[swapDevCount - 1].sd_slots;
+	dev->sd_slots = size - first;
+	if(dev->sd_slots > SWAP_MAX_SLOTS - dev->sd_base) {
+		dev->sd_slots = SWAP_MAX_SLOTS - dev->sd_base;
+	}
+	if(dev->sd_slots <= 0) {
+		return;
+	}
+	dev->sd_cursor = 0;
+	dev->sd_outstanding = 0;
+	swapDevCount++;
+}
 
 /**********************************************************
  *  initSwapStruct
  *
- *  Initializes the swap pool table and the swap pool semaphore.
- *  Sets all swap pool entries to unused state.
+ *  Carves the compressed swap tier, the swap pool table and
+ *  the swap pool out of the frames left by phys_alloc(), and
+ *  initializes the table and the swap pool semaphore.
+ *  Sets all swap pool entries to unused state, fills the
+ *  pool of second-level page tables, and lists the swap
+ *  devices, sized from their DATA1 registers. The image
+ *  sectors of RESERVED_DISK_NO are never allocated.
+ *
+ *  Parameters:
+ *
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void initSwapStruct() {
+	int i, tablePages;
+
+	zswapStart = phys_alloc(ZSWAP_PAGES);
+	/* the table takes its frames from the pool it describes */
+	tablePages = (phys_pages_left() * sizeof(swapPoolFrame_t) + PAGESIZE - 1) / PAGESIZE;
+	swapPoolTable = (swapPoolFrame_t *)phys_alloc(tablePages);
+	swapPoolSize = phys_pages_left();
+	if(swapPoolSize < SWAP_CLUSTER) {
+		PANIC();
+	}
+	swapPoolStart = phys_alloc(swapPoolSize);
+
+	/* initialize the swap pool structure */
+	for(i = 0; i < swapPoolSize; i++) {
+		swapPoolTable[i].ASID = -1;
+		swapPoolTable[i].VPN = -1;
+		swapPoolTable[i].matchingPgTableEntry = NULL;
+		swapPoolTable[i].slotRef = NULL;
+		swapPoolTable[i].pinned = FALSE;
+		swapPoolTable[i].transit = FALSE;
+		swapPoolTable[i].imageSect = NO_SLOT;
+		swapPoolTable[i].sharers = NULL;
+	}
+	swapPoolSema4 = 1;
+	initPgTblLeaves();
+	sharerFree_h = NULL;
+	for(i = 0; i < SHARER_POOL_SIZE; i++) {
+		sharerPool[i].s_next = sharerFree_h;
+		sharerFree_h = &(sharerPool[i]);
+	}
+
+	for(i = 0; i < SWAP_MAX_SLOTS / 32; i++) {
+		swapMap[i] = 0;
+	}
+	swapDevCount = 0;
+	swapNextDev = 0;
+	add_swap_dev(DISKINT, RESERVED_DISK_NO, 0);
+	for(i = 0; i < DEVPERINT; i++) {
+		if(i != RESERVED_DISK_NO && (SWAP_DISK_MASK & (1 << i)) != 0) {
+			add_swap_dev(DISKINT, i, 0);
+		}
+	}
+	for(i = 0; i < DEVPERINT; i++) {
+		if((SWAP_FLASH_MASK & (1 << i)) != 0) {
+			add_swap_dev(FLASHINT, i, SWAP_FLASH_FIRST);
+		}
+	}
+	for(i = 0; i < SWAP_FIRST_SLOT; i++) {
+		swapMap[i >> 5] |= 1 << (i & 31);
+	}
+
+	for(i = 0; i < ZSWAP_CHUNKS / 32; i++) {
+		zswapMap[i] = 0;
+	}
+	zswapCursor = 0;
+	for(i = 0; i <= MAXUPROC; i++) {
+		zswapStats[i].z_stored = 0;
+		zswapStats[i].z_words = 0;
+		zswapStats[i].z_hits = 0;
+		zswapStats[i].z_reads = 0;
+	}
+}
+
+/**********************************************************
+ *  helper_alloc_run
+ *
+ *  Finds and marks consecutive clear bits in a range of a
+ *  bitmap, next fit from the cursor, which is then moved
+ *  past them.
+ *
+ *  Parameters:
+ *         unsigned int *map – bitmap
+ *         int first – first bit of the range
+ *         int size – bits in the range
+ *         int *cursor – where to start, from first
+ *         int count – bits wanted
+ *
+ *  Returns:
+ *         int – first bit of the run, -1 if there is none
+ **********************************************************/
+HIDDEN int helper_alloc_run(unsigned int *map, int first, int size, int *cursor, int count) {
+	int tried, start, i, bit;
+
+	start = *cursor;
+	for(tried = 0; tried < size; tried++) {
+		if(start + count > size) {
+			start = 0;
+		}
+		bit = first + start;
+		for(i = 0; i < count && (map[(bit + i) >> 5] & (1 << ((bit + i) & 31))) == 0; i++) {
+			;
+		}
+		if(i == count) {
+			for(i = bit; i < bit + count; i++) {
+				map[i >> 5] |= 1 << (i & 31);
+			}
+			*cursor = (start + count) % size;
+			return bit;
+		}
+		/* restart past the bit in use */
+		start = start + i + 1;
+	}
+	return -1;
+}
+
+/**********************************************************
+ *  swap_dev
+ *
+ *  Finds the swap device holding a swap slot.
+ *
+ *  Parameters:
+ *         int slot – swap slot
+ *
+ *  Returns:
+ *         swapDev_t * – its device
+ **********************************************************/
+HIDDEN swapDev_t *swap_dev(int slot) {
+	int d;
+	for(d = swapDevCount - 1; d > 0 && slot < swapDevs[d].sd_base; d--) {
+		;
+	}
+	return &(swapDevs[d]);
+}
+
+/**********************************************************
+ *  swap_alloc_on
+ *
+ *  Allocates consecutive free swap slots of one device, next
+ *  fit from where its last run ended, so that clusters are
+ *  written in order. Each slot starts with one reference.
+ *
+ *  Parameters:
+ *         swapDev_t *dev – swap device
+ *         int count – slots wanted
+ *
+ *  Returns:
+ *         int – first swap slot, NO_SLOT if there is no such run
+ **********************************************************/
+HIDDEN int swap_alloc_on(swapDev_t *dev, int count) {
+	int slot = helper_alloc_run(swapMap, dev->sd_base, dev->sd_slots, &(dev->sd_cursor), count);
+	int i;
+
+	if(slot == -1) {
+		return NO_SLOT;
+	}
+	for(i = slot; i < slot + count; i++) {
+		swapRefs[i] = 1;
+	}
+	return slot;
+}
+
+/**********************************************************
+ *  swap_alloc_run
+ *
+ *  Allocates consecutive free swap slots on the least loaded
+ *  swap device that has them; devices with the same number
+ *  of outstanding requests are taken round robin. Must be
+ *  called holding the swap pool semaphore.
+ *
+ *  Parameters:
+ *         int count – slots wanted
+ *
+ *  Returns:
+ *         int – first swap slot, NO_SLOT if no device has such a run
+ **********************************************************/
+HIDDEN int swap_alloc_run(int count) {
+	int tried[SWAP_MAX_DEVS];
+	int d, i, best, slot;
+
+	for(d = 0; d < swapDevCount; d++) {
+		tried[d] = FALSE;
+	}
+	for(i = 0; i < swapDevCount; i++) {
+		best = -1;
+		for(d = swapNextDev; d < swapNextDev + swapDevCount; d++) {
+			if(!tried[d % swapDevCount] && (best == -1 || swapDevs[d % swapDevCount].sd_outstanding < swapDevs[best].sd_outstanding)) {
+				best = d % swapDevCount;
+			}
+		}
+		tried[best] = TRUE;
+		slot = swap_alloc_on(&(swapDevs[best]), count);
+		if(slot != NO_SLOT) {
+			swapNextDev = (best + 1) % swapDevCount;
+			return slot;
+		}
+	}
+	return NO_SLOT;
+}
+
+/**********************************************************
+ *  zswap_compress
+ *
+ *  Encodes a page as runs of words: a token word with the
+ *  run length shifted left by one, then either the repeated
+ *  word (low bit set) or the run of literal words (low bit
+ *  clear). The first word of the result is its length.
+ *
+ *  Parameters:
+ *         int *src – page
+ *         int *dst – ZSWAP_MAX_WORDS words
+ *
+ *  Returns:
+ *         int – words written, -1 if the page needs more
+ *               than ZSWAP_MAX_WORDS
+ **********************************************************/
+HIDDEN int zswap_compress(int *src, int *dst) {
+	int i = 0, out = 1, lit = -1, run;
+
+	while(i < PAGESIZE / WORDLEN) {
+		for(run = 1; i + run < PAGESIZE / WORDLEN && src[i + run] == src[i]; run++) {
+			;
+		}
+		if(run >= 3) {
+			if(out + 2 > ZSWAP_MAX_WORDS) {
+				return -1;
+			}
+			dst[out] = (run << 1) | 1;
+			dst[out + 1] = src[i];
+			out += 2;
+			i += run;
+			lit = -1;
+		} else {
+			/* shorter runs are cheaper as literals */
+			if(out + run + (lit == -1) > ZSWAP_MAX_WORDS) {
+				return -1;
+			}
+			if(lit == -1) {
+				lit = out;
+				dst[lit] = 0;
+				out++;
+			}
+			for(; run > 0; run--) {
+				dst[out] = src[i];
+				dst[lit] += 2;
+				out++;
+				i++;
+			}
+		}
+	}
+	dst[0] = out;
+	return out;
+}
+
+/**********************************************************
+ *  zswap_decompress
+ *
+ *  Decodes a page encoded by zswap_compress().
+ *
+ *  Parameters:
+ *         int *src – encoded page
+ *         int *dst – page
+ *
+ *  Returns:
+ *
+ **********************************************************/
+HIDDEN void zswap_decompress(int *src, int *dst) {
+	int in = 1, n;
+
+	while(in < src[0]) {
+		n = src[in] >> 1;
+		if((src[in] & 1) == 1) {
+			for(; n > 0; n--) {
+				*dst = src[in + 1];
+				dst++;
+			}
+			in += 2;
+		} else {
+			for(in++; n > 0; n--) {
+				*dst = src[in];
+				dst++;
+				in++;
+			}
+		}
+	}
+}
+
+/**********************************************************
+ *  zswap_store
+ *
+ *  Puts a page in the compressed swap tier if it compresses
+ *  well enough and there is room, with one reference. Must be
+ *  called holding the swap pool semaphore.
+ *
+ *  Parameters:
+ *         memaddr frameAddr – page
+ *         int asid – owner of the page
+ *
+ *  Returns:
+ *         int – its swap slot, NO_SLOT if it was not stored
+ **********************************************************/
+HIDDEN int zswap_store(memaddr frameAddr, int asid) {
+	int words = zswap_compress((int *)frameAddr, zswapBuf);
+	int chunk, i;
+	int *dst;
+
+	if(words == -1) {
+		return NO_SLOT;
+	}
+	chunk = helper_alloc_run(zswapMap, 0, ZSWAP_CHUNKS, &zswapCursor, (words * WORDLEN + ZSWAP_CHUNK - 1) / ZSWAP_CHUNK);
+	if(chunk == -1) {
+		return NO_SLOT;
+	}
+	dst = (int *)(zswapStart + chunk * ZSWAP_CHUNK);
+	for(i = 0; i < words; i++) {
+		dst[i] = zswapBuf[i];
+	}
+	zswapRefs[chunk] = 1;
+	zswapStats[asid].z_stored++;
+	zswapStats[asid].z_words += words;
+	return ZSWAP_SLOT | chunk;
+}
+
+/**********************************************************
+ *  swap_share
+ *
+ *  Adds a reference to a swap slot, on a swap device or in
+ *  the compressed tier; image sectors and NO_SLOT are not
+ *  counted. Must be called holding the swap pool semaphore.
+ *
+ *  Parameters:
+ *         int slot – swap slot
+ *
+ *  Returns:
+ *
+ **********************************************************/
+HIDDEN void swap_share(int slot) {
+	if(isZswapSlot(slot)) {
+		zswapRefs[slot & ~ZSWAP_SLOT]++;
+	} else if(slot >= SWAP_FIRST_SLOT) {
+		swapRefs[slot]++;
+	}
+}
+
+/**********************************************************
+ *  swap_free
+ *
+ *  Drops a reference to a swap slot, on a swap device or in
+ *  the compressed tier, and releases the slot with its last
+ *  one; image sectors and NO_SLOT are ignored. Must be called
+ *  holding the swap pool semaphore.
+ *
+ *  Parameters:
+ *         int slot – swap slot
+ *
+ *  Returns:
+ *
+ **********************************************************/
+HIDDEN void swap_free(int slot) {
+	int i, chunks;
+
+	if(isZswapSlot(slot)) {
+		slot &= ~ZSWAP_SLOT;
+		zswapRefs[slot]--;
+		if(zswapRefs[slot] > 0) {
+			return;
+		}
+		chunks = (*((int *)(zswapStart + slot * ZSWAP_CHUNK)) * WORDLEN + ZSWAP_CHUNK - 1) / ZSWAP_CHUNK;
+		for(i = slot; i < slot + chunks; i++) {
+			zswapMap[i >> 5] &= ~(1 << (i & 31));
+		}
+	} else if(slot >= SWAP_FIRST_SLOT) {
+		swapRefs[slot]--;
+		if(swapRefs[slot] == 0) {
+			swapMap[slot >> 5] &= ~(1 << (slot & 31));
+		}
+	}
+}
+
+/**********************************************************
+ *  swap_wait_transit
+ *
+ *  Waits for the next page in transit to land. Must be called
+ *  holding the swap pool semaphore, which is released while
+ *  waiting and held again on return; the caller checks again
+ *  whatever it was waiting for.
+ *
+ *  Parameters:
+ *
+ *
+ *  Returns:
+ *
+ **********************************************************/
+HIDDEN void swap_wait_transit() {
+	swapWaiters++;
+	SYSCALL(VERHO, &swapPoolSema4, 0, 0);
+	SYSCALL(PASSERN, &swapTransitSema4, 0, 0);
+	SYSCALL(PASSERN, &swapPoolSema4, 0, 0);
+}
+
+/**********************************************************
+ *  swap_wake_transit
+ *
+ *  Wakes every fault waiting in swap_wait_transit(). Must be
+ *  called holding the swap pool semaphore.
+ *
+ *  Parameters:
+ *
+ *
+ *  Returns:
+ *
+ **********************************************************/
+HIDDEN void swap_wake_transit() {
+	while(swapWaiters > 0) {
+		swapWaiters--;
+		SYSCALL(VERHO, &swapTransitSema4, 0, 0);
+	}
+}
+
+/**********************************************************
+ *  helper_in_transit
+ *
+ *  Tells whether a page is being read or written, as the
+ *  first mapping of a frame or as one of its sharers.
+ *
+ *  Parameters:
+ *         int *slotRef – swap slot entry of the page
+ *
+ *  Returns:
+ *         int – TRUE if a frame in transit holds the page
+ **********************************************************/
+HIDDEN int helper_in_transit(int *slotRef) {
+	int i;
+	sharer_t *s;
+	for(i = 0; i < swapPoolSize; i++) {
+		if(swapPoolTable[i].transit == TRUE) {
+			if(swapPoolTable[i].slotRef == slotRef) {
+				return TRUE;
+			}
+			for(s = swapPoolTable[i].sharers; s != NULL; s = s->s_next) {
+				if(s->s_slotRef == slotRef) {
+					return TRUE;
+				}
+			}
+		}
+	}
+	return FALSE;
+}
+
+/**********************************************************
+ *  helper_maps_asid
+ *
+ *  Tells whether a frame is mapped by a U-proc, as its first
+ *  mapping or as one of its sharers.
+ *
+ *  Parameters:
+ *         int frame – swap pool frame index
+ *         int asid – ASID of the U-proc
+ *
+ *  Returns:
+ *         int – TRUE if the U-proc maps the frame
+ **********************************************************/
+HIDDEN int helper_maps_asid(int frame, int asid) {
+	sharer_t *s;
+	if(swapPoolTable[frame].ASID == asid) {
+		return TRUE;
+	}
+	for(s = swapPoolTable[frame].sharers; s != NULL; s = s->s_next) {
+		if(s->s_asid == asid) {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/**********************************************************
+ *  helper_find_leaf
+ *
+ *  Looks up the second-level page table mapping the given
+ *  VPN in the U-proc's first-level table. The first-level
+ *  table is hashed by range with linear probing; leaves are
+ *  only removed all at once, so an empty slot ends the probe.
+ *  alloc_leaf() always leaves one slot empty, which lets
+ *  uTLB_RefillHandler() probe without a bound.
+ *
+ *  Parameters:
+ *         support_t *currentSupport – owner of the page table
+ *         int VPN – virtual page number
+ *
+ *  Returns:
+ *         pgTblLeaf_t * – the leaf, NULL if the range is not mapped yet
+ **********************************************************/
+pgTblLeaf_t *helper_find_leaf(support_t *currentSupport, int VPN) {
+	int region = VPN >> LEAF_SHIFT;
+	int slot = region & (PGDIR_SIZE - 1);
+	int probe;
+	for(probe = 0; probe < PGDIR_SIZE; probe++) {
+		if(currentSupport->sup_pgDir[slot] == NULL || currentSupport->sup_pgDir[slot]->l_region == region) {
+			return currentSupport->sup_pgDir[slot];
+		}
+		slot = (slot + 1) & (PGDIR_SIZE - 1);
+	}
+	return NULL;
+}
+
+/**********************************************************
+ *  helper_find_pte
+ *
+ *  Returns the page table entry of the given VPN, or NULL if
+ *  the range holding it has no second-level table yet.
+ *
+ *  Parameters:
+ *         support_t *currentSupport – owner of the page table
+ *         int VPN – virtual page number
+ *
+ *  Returns:
+ *         pte_t * – the entry, or NULL
+ **********************************************************/
+pte_t *helper_find_pte(support_t *currentSupport, int VPN) {
+	pgTblLeaf_t *leaf = helper_find_leaf(currentSupport, VPN);
+	if(leaf == NULL) {
+		return NULL;
+	}
+	return &(leaf->l_pte[VPN & (PGTBL_LEAF_SIZE - 1)]);
+}
+
+/**********************************************************
+ *  alloc_leaf
+ *
+ *  Returns the second-level page table mapping the given VPN,
+ *  allocating it from the leaf pool on first use. The pages
+ *  of the range holding the U-proc image start from the
+ *  copies staged by set_up_backing_store(); any other page
+ *  starts with no swap slot.
+ *  Must be called holding the swap pool semaphore.
+ *
+ *  Parameters:
+ *         support_t *currentSupport – owner of the page table
+ *         int VPN – virtual page number
+ *
+ *  Returns:
+ *         pgTblLeaf_t * – the leaf, NULL if VPN is outside kuseg
+ *                         or no table is left
+ **********************************************************/
+pgTblLeaf_t *alloc_leaf(support_t *currentSupport, int VPN) {
+	if(VPN < STARTVPN || VPN > UPROC_STACK_VPN) {
+		return NULL;
+	}
+	pgTblLeaf_t *leaf = helper_find_leaf(currentSupport, VPN);
+	if(leaf != NULL) {
+		return leaf;
+	}
+	/* the last free slot is kept as the refill handler's probe sentinel */
+	if(currentSupport->sup_leafCount >= PGDIR_SIZE - 1 || leafFree_h == NULL) {
+		return NULL;
+	}
+
+	/* find the free slot of the first-level table */
+	int region = VPN >> LEAF_SHIFT;
+	int slot = region & (PGDIR_SIZE - 1);
+	while(currentSupport->sup_pgDir[slot] != NULL) {
+		slot = (slot + 1) & (PGDIR_SIZE - 1);
+	}
+
+	leaf = leafFree_h;
+	leafFree_h = leaf->l_next;
+	leaf->l_next = NULL;
+	leaf->l_region = region;
+
+	/* ASID field, for any given Page Table, will all be set to the U-proc’s unique ID*/
+	int i;
+	for(i = 0; i < PGTBL_LEAF_SIZE; i++) {
+		leaf->l_pte[i].EntryHi = (((region << LEAF_SHIFT) + i) << VPN_SHIFT) + (currentSupport->sup_asid << ASID_SHIFT);
+		leaf->l_pte[i].EntryLo = (DBITON & GBITOFF) & VBITOFF;
+		if(region == (STARTVPN >> LEAF_SHIFT)) {
+			leaf->l_slot[i] = imageSect[currentSupport->sup_asid - 1][i];
+		} else {
+			leaf->l_slot[i] = NO_SLOT;
+		}
+	}
+
+	currentSupport->sup_pgDir[slot] = leaf;
+	currentSupport->sup_leafCount++;
+	return leaf;
+}
+
+/**********************************************************
+ *  free_pgTable
+ *
+ *  Returns all second-level page tables of a U-proc to the
+ *  leaf pool, and their swap slots to the bitmap. Must be
+ *  called holding the swap pool semaphore.
+ *
+ *  Parameters:
+ *         support_t *currentSupport – owner of the page table
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void free_pgTable(support_t *currentSupport) {
+	int i, j;
+	for(i = 0; i < PGDIR_SIZE; i++) {
+		if(currentSupport->sup_pgDir[i] != NULL) {
+			for(j = 0; j < PGTBL_LEAF_SIZE; j++) {
+				swap_free(currentSupport->sup_pgDir[i]->l_slot[j]);
+			}
+			currentSupport->sup_pgDir[i]->l_region = NO_REGION;
+			currentSupport->sup_pgDir[i]->l_next = leafFree_h;
+			leafFree_h = currentSupport->sup_pgDir[i];
+			currentSupport->sup_pgDir[i] = NULL;
+		}
+	}
+	currentSupport->sup_leafCount = 0;
+}
+
+/**********************************************************
+ *  helper_tlb_invalidate
+ *
+ *  Drops the TLB entry matching the given EntryHi (VPN and
+ *  ASID), if there is one, instead of clearing the whole TLB.
+ *  Must be called with interrupts disabled.
+ *
+ *  Parameters:
+ *         unsigned int entryHi – VPN and ASID of the entry
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void helper_tlb_invalidate(unsigned int entryHi) {
+	unsigned int savedEntryHi = getENTRYHI();
+
+	setENTRYHI(entryHi);
+	TLBP();
+	if((getINDEX() & INDEXPBIT) == 0) {
+		/* matching entry found: overwrite it with an invalid one */
+		setENTRYLO(ALLOFF);
+		TLBWI();
+	}
+	/* EntryHi also holds the running ASID, put it back */
+	setENTRYHI(savedEntryHi);
+}
+
+/**********************************************************
+ *  uTLB_RefillHandler
+ *
+ *  Handles TLB refill exceptions by inserting the missing
+ *  page’s mapping into the TLB from the current process's page table.
+ *  This runs on every TLB miss, so it reads the page table through
+ *  currentPgDir, which the scheduler sets on every dispatch, and the
+ *  debug hook and the HIST_REFILL sample are only built with
+ *  -DPANDOS_DEBUG.
+ *
+ *  Parameters:
+ *
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void uTLB_RefillHandler() {
+#ifdef PANDOS_DEBUG
+	cpu_t refillStart, refillEnd;
+	STCK(refillStart);
+#endif
+	unsigned int missingEntryHi = EXCSTATE->s_entryHI;
+	pgTblLeaf_t **pgDir = currentPgDir;
+#ifdef PANDOS_DEBUG
+	debugTLBrefill(missingEntryHi, 0xaa, 0xaa, 0xaa);
+#endif
+
+	/* Get the Page Table entry for page number p for the Current Process, through the
+	first-level table cached by the scheduler: shifts and masks only, no division */
+	int region = missingEntryHi >> (VPN_SHIFT + LEAF_SHIFT);
+	int slot = region & (PGDIR_SIZE - 1);
+	pgTblLeaf_t *leaf = pgDir[slot];
+	while(leaf != NULL && leaf->l_region != region) {
+		slot = (slot + 1) & (PGDIR_SIZE - 1);
+		leaf = pgDir[slot];
+	}
+
+	/* Write this Page Table entry into the TLB*/
+	if(leaf != NULL) {
+		pte_t *pte = &(leaf->l_pte[(missingEntryHi >> VPN_SHIFT) & (PGTBL_LEAF_SIZE - 1)]);
+		setENTRYHI(pte->EntryHi);
+		setENTRYLO(pte->EntryLo);
+	} else {
+		/* no second-level table for this range yet: an invalid entry sends the access to the pager, which builds it */
+		setENTRYHI(missingEntryHi);
+		setENTRYLO(ALLOFF);
+	}
+	TLBWR();
+
+#ifdef PANDOS_DEBUG
+	STCK(refillEnd);
+	hist_record((missingEntryHi >> ASID_SHIFT) & ASID_MASK, HIST_REFILL, refillEnd - refillStart);
+#endif
+
+	LDST(EXCSTATE);
+}
+
+/**********************************************************
+ *  page_replace
+ *
+ *  Selects a free or replaceable frame from the swap pool
+ *  using a simple FIFO algorithm. Frames pinned or in
+ *  transit are skipped. Frames of U-procs suspended by
+ *  load control go first, unless shared.
+ *
+ *  Parameters:
+ *         int fifoOnly – TRUE to skip the suspended U-procs'
+ *                        frames, when one of them could not be
+ *                        paged out
+ *
+ *  Returns:
+ *         int – index of the selected swap pool frame, -1 if
+ *               every frame is pinned or in transit
+ **********************************************************/
+int page_replace(int fifoOnly) {
+	static int nextFrame = 0;
+
+	/* Look for an empty frame */
+	int pickedFrame;
+	for(pickedFrame = 0; pickedFrame < swapPoolSize; pickedFrame = pickedFrame + 1) {
+		if(swapPoolTable[pickedFrame].ASID == -1) {
+			/* so that frame i doesn't get replace right away next time but only after circulated */
+			if(pickedFrame == nextFrame) {
+				nextFrame = (nextFrame + 1) % swapPoolSize;
+			}
+			return pickedFrame;
+		}
+	}
+
+	/* Then the oldest frame of a suspended U-proc: swapping it out costs nobody running */
+	int tried;
+	for(tried = 0, pickedFrame = nextFrame; fifoOnly == FALSE && tried < swapPoolSize; tried++, pickedFrame = (pickedFrame + 1) % swapPoolSize) {
+		swapPoolFrame_t *frame = &(swapPoolTable[pickedFrame]);
+		if(load_suspended(frame->ASID) && frame->pinned == FALSE && frame->transit == FALSE && frame->sharers == NULL) {
+			return pickedFrame;
+		}
+	}
+
+	/* If no free frame, select the oldest one (FIFO) that is not pinned by an in-flight SENDMSG nor in transit */
+	for(tried = 0; swapPoolTable[nextFrame].pinned == TRUE || swapPoolTable[nextFrame].transit == TRUE; tried++) {
+		if(tried == swapPoolSize) {
+			return -1;
+		}
+		nextFrame = (nextFrame + 1) % (swapPoolSize);
+	}
+	int selectedFrame = nextFrame;
+	/* Move to next in circular order */
+	nextFrame = (nextFrame + 1) % (swapPoolSize);
+
+	return selectedFrame;
+}
+
+HIDDEN void helper_zero_frame(int *dst){
+    int i;
+    for (i = 0; i < (PAGESIZE/4); i++){
+        *dst = 0;
+        dst++;
+    }
+}
+
+/**********************************************************
+ *  helper_swap_transfer
+ *
+ *  Reads or writes one page at a swap slot. On a disk, a seek
+ *  is done only when the cylinder differs from the one the
+ *  head is on. Must be called holding the mutex of the
+ *  slot's device; start every hold with *cylinder = -1.
+ *
+ *  Parameters:
+ *         int slot – swap slot
+ *         memaddr frameAddr – page to transfer
+ *         int isRead – TRUE to read the page, FALSE to write it
+ *         int *cylinder – cylinder the head is on, updated
+ *
+ *  Returns:
+ *         int – device status, READY on success
+ **********************************************************/
+HIDDEN int helper_swap_transfer(int slot, memaddr frameAddr, int isRead, int *cylinder) {
+	swapDev_t *dev = swap_dev(slot);
+	int block = dev->sd_first + (slot - dev->sd_base);
+	int diskStatus;
+
+	if(dev->sd_line == FLASHINT) {
+		return SYSCALL(DOIO, doioDev(FLASHINT, dev->sd_devNo, FALSE), (block << BLOCKNUM_SHIFT) + (isRead ? READBLK_FLASH : WRITEBLK_FLASH), frameAddr);
+	}
+
+	int cylNo = block / (dev->sd_heads * dev->sd_sects);
+	int headNo = (block % (dev->sd_heads * dev->sd_sects)) / dev->sd_sects;
+	int sectNo = block % dev->sd_sects;
+
+	if(cylNo != *cylinder) {
+		diskStatus = SYSCALL(DOIO, doioDev(DISKINT, dev->sd_devNo, FALSE), (cylNo << CYLNUM_SHIFT) + SEEKCYL, 0);
+		if(diskStatus != READY) {
+			return diskStatus;
+		}
+		*cylinder = cylNo;
+	}
+	return SYSCALL(DOIO, doioDev(DISKINT, dev->sd_devNo, FALSE), (headNo << HEADNUM_SHIFT) + (sectNo << SECTNUM_SHIFT) + (isRead ? READBLK_DSK : WRITEBLK_DSK), frameAddr);
+}
+
+/**********************************************************
+ *  swap_io
+ *
+ *  Reads or writes swap slots of one device, in increasing
+ *  order, from or to the given frames, with the swap pool
+ *  semaphore released; the frames must be in transit. Must
+ *  be called holding the swap pool semaphore, which is held
+ *  again on return.
+ *
+ *  Parameters:
+ *         int *slots – swap slots
+ *         int *frames – swap pool frame index of each slot
+ *         int count – slots to transfer
+ *         int isRead – TRUE to read the pages, FALSE to write them
+ *
+ *  Returns:
+ *         int – device status, READY on success
+ **********************************************************/
+HIDDEN int swap_io(int *slots, int *frames, int count, int isRead) {
+	swapDev_t *dev = swap_dev(slots[0]);
+	int devSem = devSemIdx(dev->sd_line, dev->sd_devNo, FALSE);
+	int cylinder = -1;
+	int i, ioStatus = READY;
+
+	dev->sd_outstanding++;
+	SYSCALL(VERHO, &swapPoolSema4, 0, 0);
+
+	SYSCALL(PASSERN, &(mutex[devSem]), 0, 0);
+	for(i = 0; i < count && ioStatus == READY; i++) {
+		ioStatus = helper_swap_transfer(slots[i], swapPoolStart + (frames[i] * PAGESIZE), isRead, &cylinder);
+	}
+	SYSCALL(VERHO, &(mutex[devSem]), 0, 0);
+
+	SYSCALL(PASSERN, &swapPoolSema4, 0, 0);
+	dev->sd_outstanding--;
+	return ioStatus;
+}
+
+/**********************************************************
+ *  helper_free_frame
+ *
+ *  Marks a swap pool frame as unoccupied, giving back the
+ *  mappings of its other sharers, if any.
+ *
+ *  Parameters:
+ *         int frame – swap pool frame index
+ *
+ *  Returns:
+ *
+ **********************************************************/
+HIDDEN void helper_free_frame(int frame) {
+	sharer_t *s;
+
+	while((s = swapPoolTable[frame].sharers) != NULL) {
+		swapPoolTable[frame].sharers = s->s_next;
+		s->s_next = sharerFree_h;
+		sharerFree_h = s;
+	}
+	swapPoolTable[frame].ASID = -1;
+	swapPoolTable[frame].VPN = -1;
+	swapPoolTable[frame].matchingPgTableEntry = NULL;
+	swapPoolTable[frame].slotRef = NULL;
+	swapPoolTable[frame].pinned = FALSE;
+	swapPoolTable[frame].imageSect = NO_SLOT;
+}
+
+/**********************************************************
+ *  unmap_frame
+ *
+ *  Removes one mapping of a frame. If it was the first one,
+ *  the next sharer takes its place; if it was the only one,
+ *  the frame is left free. Must be called holding the swap
+ *  pool semaphore.
  *
  *  Parameters:
- *
+ *         int frame – swap pool frame index
+ *         pte_t *pte – page table entry of the mapping
  *
  *  Returns:
  *
  **********************************************************/
-void initSwapStruct() {
-	/* initialize the swap pool structure */
-	int i;
-	for(i = 0; i < SWAP_POOL_SIZE; i++) {
-		swapPoolTable[i].ASID = -1;
-		swapPoolTable[i].VPN = -1;
-		swapPoolTable[i].matchingPgTableEntry = NULL;
+HIDDEN void unmap_frame(int frame, pte_t *pte) {
+	swapPoolFrame_t *f = &(swapPoolTable[frame]);
+	sharer_t *s, **link;
+
+	if(f->matchingPgTableEntry == pte) {
+		s = f->sharers;
+		if(s == NULL) {
+			helper_free_frame(frame);
+			return;
+		}
+		f->ASID = s->s_asid;
+		f->VPN = s->s_vpn;
+		f->matchingPgTableEntry = s->s_pte;
+		f->slotRef = s->s_slotRef;
+		f->sharers = s->s_next;
+	} else {
+		for(link = &(f->sharers); (*link)->s_pte != pte; link = &((*link)->s_next)) {
+			;
+		}
+		s = *link;
+		*link = s->s_next;
 	}
-	swapPoolSema4 = 1;
+	s->s_next = sharerFree_h;
+	sharerFree_h = s;
 }
 
 /**********************************************************
- *  uTLB_RefillHandler
+ *  share_image_frame
  *
- *  Handles TLB refill exceptions by inserting the missing
- *  page’s mapping into the TLB from the current process's page table.
+ *  Maps an image page, read-only, to a resident frame that
+ *  holds the same image sector unmodified, if there is one.
+ *  Must be called holding the swap pool semaphore.
  *
  *  Parameters:
- *
+ *         support_t *currentSupport – support struct of the faulting U-proc
+ *         int VPN – the missing page
+ *         pte_t *pte – its page table entry
+ *         int *slotRef – its swap slot entry
  *
  *  Returns:
- *
+ *         int – TRUE if the page is now mapped
  **********************************************************/
-void uTLB_RefillHandler() {
-	int missingVPN = (((state_PTR)BIOSDATAPAGE)->s_entryHI >> VPN_SHIFT) & VPN_MASK;
-	debugTLBrefill(((state_PTR)BIOSDATAPAGE)->s_entryHI, 0xaa, 0xaa, 0xaa);
+HIDDEN int share_image_frame(support_t *currentSupport, int VPN, pte_t *pte, int *slotRef) {
+	int frame;
+	sharer_t *s;
 
-	/* Get the Page Table entry for page number p for the Current Process. This will be located in the Current Process’s Page Table*/
-	int missingVPN_idx_in_pgTable = missingVPN % PAGE_TABLE_SIZE;
-
-	support_t *currentSupport = currentP->p_supportStruct;
-	pte_t *pte = &(currentSupport->sup_privatePgTbl[missingVPN_idx_in_pgTable]);
+	if(*slotRef == NO_SLOT || *slotRef >= SWAP_FIRST_SLOT || sharerFree_h == NULL) {
+		return FALSE;
+	}
+	for(frame = 0; frame < swapPoolSize; frame++) {
+		if(swapPoolTable[frame].imageSect == *slotRef && swapPoolTable[frame].transit == FALSE) {
+			break;
+		}
+	}
+	if(frame == swapPoolSize) {
+		return FALSE;
+	}
 
-	/* Write this Page Table entry into the TLB*/
-	setENTRYHI(pte->EntryHi);
-	setENTRYLO(pte->EntryLo);
-	TLBWR();
+	s = sharerFree_h;
+	sharerFree_h = s->s_next;
+	s->s_asid = currentSupport->sup_asid;
+	s->s_vpn = VPN;
+	s->s_pte = pte;
+	s->s_slotRef = slotRef;
+	s->s_next = swapPoolTable[frame].sharers;
+	swapPoolTable[frame].sharers = s;
 
-	LDST((state_PTR)BIOSDATAPAGE);
+	setSTATUS(getSTATUS() & (~IECBITON));
+	pte->EntryLo = (swapPoolStart + (frame * PAGESIZE)) | VBITON;
+	TLBCLR();
+	tlb_shootdown();
+	setSTATUS(getSTATUS() | IECBITON);
+	return TRUE;
 }
 
 /**********************************************************
- *  page_replace
+ *  helper_drop_slots
  *
- *  Selects a free or replaceable frame from the swap pool
- *  using a simple FIFO algorithm.
+ *  Drops the reference every mapping of a frame holds to its
+ *  old swap slot, before the frame is paged out again. Must
+ *  be called holding the swap pool semaphore.
  *
  *  Parameters:
- *
+ *         int frame – swap pool frame index
  *
  *  Returns:
- *         int – index of the selected swap pool frame
+ *
  **********************************************************/
-int page_replace() {
-	static int nextFrame = 0;
+HIDDEN void helper_drop_slots(int frame) {
+	sharer_t *s;
 
-	/* Look for an empty frame */
-	int pickedFrame;
-	for(pickedFrame = 0; pickedFrame < SWAP_POOL_SIZE; pickedFrame = pickedFrame + 1) {
-		if(swapPoolTable[pickedFrame].ASID == -1) {
-			/* so that frame i doesn't get replace right away next time but only after circulated */
-			if(pickedFrame == nextFrame) {
-				nextFrame = (nextFrame + 1) % SWAP_POOL_SIZE;
-			}
-			return pickedFrame;
-		}
+	swap_free(*(swapPoolTable[frame].slotRef));
+	for(s = swapPoolTable[frame].sharers; s != NULL; s = s->s_next) {
+		swap_free(*(s->s_slotRef));
 	}
-
-	/* If no free frame, select the oldest one (FIFO) */
-	int selectedFrame = nextFrame;
-	/* Move to next in circular order */
-	nextFrame = (nextFrame + 1) % (SWAP_POOL_SIZE);
-
-	return selectedFrame;
 }
 
 /**********************************************************
- *  read_write_flash
+ *  helper_set_slot
  *
- *  Performs a flash read or write operation for paging.
- *  Transfers a memory page to or from the U-proc's flash device.
+ *  Records the swap slot a frame was paged out to in the
+ *  page table of every mapping of the frame, each holding a
+ *  reference; the slot comes with the first one. Must be
+ *  called holding the swap pool semaphore.
  *
  *  Parameters:
- *         pickedSwapPoolFrame – index of the memory frame
- *         devNo – flash device number
- *         blockNo – logical page number in the flash
- *         isRead – 1 for read, 0 for write
+ *         int frame – swap pool frame index
+ *         int slot – swap slot
  *
  *  Returns:
  *
  **********************************************************/
-void read_write_flash(int pickedSwapPoolFrame, support_t *currentSupport, int blockNo, int isRead) {
-	int devNo = swapPoolTable[pickedSwapPoolFrame].ASID - 1;
-	if(isRead == TRUE) {
-		devNo = currentSupport->sup_asid - 1;
-	}
-	int flashSemIdx = devSemIdx(FLASHINT, devNo, FALSE);
+HIDDEN void helper_set_slot(int frame, int slot) {
+	sharer_t *s;
 
-	/* Get the device register address for the U-proc’s flash device */
-	device_t *flashDevRegAdd = devAddrBase(FLASHINT, devNo);
+	*(swapPoolTable[frame].slotRef) = slot;
+	for(s = swapPoolTable[frame].sharers; s != NULL; s = s->s_next) {
+		*(s->s_slotRef) = slot;
+		swap_share(slot);
+	}
+}
 
-	SYSCALL(PASSERN, &(mutex[flashSemIdx]), 0, 0);
+/**********************************************************
+ *  page_out_cluster
+ *
+ *  Pages out the victim frame together with the occupied
+ *  frames FIFO would evict after it, up to SWAP_CLUSTER of
+ *  them. Unmodified image frames are just dropped, for every
+ *  U-proc sharing them. Of the other pages, those that
+ *  compress well enough go to the compressed tier and the
+ *  rest are written into consecutive swap slots of one
+ *  device; a modified frame shared after a FORK is written
+ *  once, for all of its mappings. The cluster shrinks to
+ *  what the free slots allow; with no free slot at all the
+ *  victim goes back to its own slot, if nobody else uses
+ *  it, and otherwise stays resident: its owner gets its
+ *  mapping back and its sharers theirs, read-only as every
+ *  mapping of a shared frame. All the frames of the cluster
+ *  but such a victim are left free. Must be
+ *  called holding the swap pool semaphore, which is released
+ *  during the write; the victim stays in transit until the
+ *  write is over, so that no other fault takes it meanwhile.
+ *
+ *  Parameters:
+ *         int victim – swap pool frame index picked by page_replace()
+ *         support_t *currentSupport – support struct of the faulting U-proc
+ *
+ *  Returns:
+ *         int – TRUE if the victim is free, FALSE if it stayed
+ **********************************************************/
+HIDDEN int page_out_cluster(int victim, support_t *currentSupport) {
+	int cluster[SWAP_CLUSTER];
+	int diskFrames[SWAP_CLUSTER], diskSlots[SWAP_CLUSTER];
+	int count, dirty, diskCount, frame, i, d, slot, zslot, ioStatus;
+	unsigned int victimLo;
+	sharer_t *s;
 
-	/* Write the physical memory address (start of frame) to DATA0 */
-	flashDevRegAdd->d_data0 = (SWAP_POOL_START + (pickedSwapPoolFrame * PAGESIZE));
+	cluster[0] = victim;
+	count = 1;
+	for(frame = (victim + 1) % swapPoolSize; count < SWAP_CLUSTER && frame != victim; frame = (frame + 1) % swapPoolSize) {
+		if(swapPoolTable[frame].ASID == -1 || swapPoolTable[frame].pinned == TRUE || swapPoolTable[frame].transit == TRUE) {
+			break;
+		}
+		cluster[count] = frame;
+		count++;
+	}
 
-	/* Choose the correct flash command */
-	int flashCommand;
-	if(isRead == FALSE) {
-		flashCommand = FLASHWRITE;
+	/* slots on the swap devices, for the modified pages that will not compress */
+	while(TRUE) {
+		dirty = 0;
+		for(i = 0; i < count; i++) {
+			if(swapPoolTable[cluster[i]].imageSect == NO_SLOT) {
+				dirty++;
+			}
+		}
+		slot = NO_SLOT;
+		if(dirty == 0 || (slot = swap_alloc_run(dirty)) != NO_SLOT || count == 1) {
+			break;
+		}
+		count--;
+	}
+	if(dirty > 0 && slot == NO_SLOT) {
+		/* swap space is full; image sectors and slots still referenced by a FORK are never written */
+		slot = *(swapPoolTable[victim].slotRef);
+		if(slot < SWAP_FIRST_SLOT || swapRefs[slot] > 1 || swapPoolTable[victim].sharers != NULL) {
+			slot = NO_SLOT;
+		}
 	} else {
-		flashCommand = FLASHREAD;
+		for(i = 0; i < count; i++) {
+			if(swapPoolTable[cluster[i]].imageSect == NO_SLOT) {
+				helper_drop_slots(cluster[i]);
+			}
+		}
 	}
 
-	/* Disable interrupts to ensure to do atomically */
+	victimLo = swapPoolTable[victim].matchingPgTableEntry->EntryLo;
+	/* disable interrupts */
 	setSTATUS(getSTATUS() & (~IECBITON));
-	/* Write the command to COMMAND register */
-	flashDevRegAdd->d_command = (blockNo << COMMAND_SHIFT) | flashCommand;
-	/* Block the process until the flash operation is complete */
-	int flashStatus = SYSCALL(IOWAIT, FLASHINT, devNo, 0);
-	/* Re-enable interrupts */
+	/* Update the owners' Page Tables: mark the entries as not valid. */
+	for(i = 0; i < count; i++) {
+		trace_record(TRACE_EVICT, swapPoolTable[cluster[i]].ASID, cluster[i], swapPoolTable[cluster[i]].VPN, 0);
+		swapPoolTable[cluster[i]].matchingPgTableEntry->EntryLo = (DBITON & GBITOFF) & VBITOFF;
+		for(s = swapPoolTable[cluster[i]].sharers; s != NULL; s = s->s_next) {
+			s->s_pte->EntryLo = (DBITON & GBITOFF) & VBITOFF;
+		}
+	}
+	/* Update the TLB, once for the whole cluster, on every processor the owners may have run on. */
+	TLBCLR();
+	tlb_shootdown();
+	/* enable interrupts */
 	setSTATUS(getSTATUS() | IECBITON);
 
-	SYSCALL(VERHO, &(mutex[flashSemIdx]), 0, 0);
+	/* no page can change any more: drop the image pages, keep what compresses in RAM */
+	swapPoolTable[victim].transit = TRUE;
+	diskCount = 0;
+	d = 0;
+	for(i = 0; i < count; i++) {
+		if(swapPoolTable[cluster[i]].imageSect != NO_SLOT) {
+			/* every mapping still has the image sector as its slot */
+			if(i > 0) {
+				helper_free_frame(cluster[i]);
+			}
+			continue;
+		}
+		zslot = zswap_store(swapPoolStart + (cluster[i] * PAGESIZE), swapPoolTable[cluster[i]].ASID);
+		if(zslot != NO_SLOT) {
+			if(slot == NO_SLOT) {
+				/* swap space is full and the old copies were kept */
+				helper_drop_slots(cluster[i]);
+			} else {
+				swap_free(slot + d);
+			}
+			helper_set_slot(cluster[i], zslot);
+			if(i > 0) {
+				helper_free_frame(cluster[i]);
+			}
+		} else {
+			diskFrames[diskCount] = cluster[i];
+			diskSlots[diskCount] = slot + d;
+			swapPoolTable[cluster[i]].transit = TRUE;
+			diskCount++;
+		}
+		d++;
+	}
+	if(diskCount == 0) {
+		swapPoolTable[victim].transit = FALSE;
+		helper_free_frame(victim);
+		return TRUE;
+	}
+	if(diskSlots[0] == NO_SLOT) {
+		/* the victim has nowhere to go: it stays, mapped as before */
+		swapPoolTable[victim].transit = FALSE;
+		setSTATUS(getSTATUS() & (~IECBITON));
+		swapPoolTable[victim].matchingPgTableEntry->EntryLo = victimLo;
+		for(s = swapPoolTable[victim].sharers; s != NULL; s = s->s_next) {
+			s->s_pte->EntryLo = (swapPoolStart + (victim * PAGESIZE)) | VBITON;
+		}
+		/* a refill may have cached the invalid entries meanwhile */
+		TLBCLR();
+		tlb_shootdown();
+		setSTATUS(getSTATUS() | IECBITON);
+		return FALSE;
+	}
+
+	/* Write the rest, one seek unless the run crosses a cylinder. */
+	ioStatus = swap_io(diskSlots, diskFrames, diskCount, FALSE);
+
+	for(i = 0; i < diskCount; i++) {
+		helper_set_slot(diskFrames[i], diskSlots[i]);
+		swapPoolTable[diskFrames[i]].transit = FALSE;
+		helper_free_frame(diskFrames[i]);
+	}
+	if(swapPoolTable[victim].transit == TRUE) {
+		/* dropped or compressed, it was kept for the caller during the write */
+		swapPoolTable[victim].transit = FALSE;
+		helper_free_frame(victim);
+	}
+	swap_wake_transit();
 
-	if(flashStatus != READY) {
+	/* Treat any error status from the write operation as a program trap.*/
+	if(ioStatus != READY) {
 		program_trap_handler(currentSupport, &swapPoolSema4);
 	}
+	return TRUE;
 }
 
+/**********************************************************
+ *  get_free_frame
+ *
+ *  Picks a frame and pages out its contents, if any. A
+ *  victim that stays, swap space being full, is passed over
+ *  for the next one in FIFO order; when no resident page can
+ *  go anywhere the faulting U-proc is terminated. Must be
+ *  called holding the swap pool semaphore, which may be
+ *  released meanwhile.
+ *
+ *  Parameters:
+ *         support_t *currentSupport – support struct of the faulting U-proc
+ *
+ *  Returns:
+ *         int – index of the free swap pool frame
+ **********************************************************/
+HIDDEN int get_free_frame(support_t *currentSupport) {
+	int frame, tried;
 
-HIDDEN void helper_copy_block(int *src, int *dst){
-    int i;
-    for (i = 0; i < (BLOCKSIZE/4); i++){
-        *dst = *src;
-        dst++; /*should increase by 4*/
-        src++;
-    }
+	for(tried = 0; tried <= swapPoolSize; tried++) {
+		while((frame = page_replace(tried > 0)) == -1) {
+			swap_wait_transit();
+		}
+		if(swapPoolTable[frame].ASID == -1 || page_out_cluster(frame, currentSupport)) {
+			return frame;
+		}
+	}
+	program_trap_handler(currentSupport, &swapPoolSema4);
+	return -1;
 }
 
-void write_to_disk_for_pager(int devNo, int sectNo2D, int src, support_t *currentSupport){
-    int disk_sem_idx = devSemIdx(DISKINT, devNo, FALSE);
-
-    device_t *disk_dev_reg_addr = devAddrBase(DISKINT, devNo);
-
-    int maxcyl = ((disk_dev_reg_addr->d_data1) >> 16) & 0xFFFF;
-    int maxhead = ((disk_dev_reg_addr->d_data1) >> 8) & 0xFF;
-    int maxsect = (disk_dev_reg_addr->d_data1) & 0xFF;
-
-	debugCheckDskDimension(maxcyl, maxhead, maxsect, 0xbb);
-
-    if (sectNo2D > (maxcyl*maxhead*maxsect)){
-        program_trap_handler(currentSupport, NULL);
-    }
-
-    SYSCALL(PASSERN, &(mutex[disk_sem_idx]), 0, 0);
-        int sectNo = (sectNo2D % (maxhead * maxsect)) % maxsect;
-		int headNo = (sectNo2D % (maxhead * maxsect)) / maxsect; /*divide and round down*/
-    	int cylNo = sectNo2D / (maxhead * maxsect);
-		debugCheckDskDimension(sectNo, headNo, cylNo, sectNo2D);
-        setSTATUS(getSTATUS() & (~IECBITON));
-            disk_dev_reg_addr->d_command = (cylNo << CYLNUM_SHIFT) + SEEKCYL; /*seek*/
-            int disk_status = SYSCALL(IOWAIT, DISKINT, devNo, 0);
-        setSTATUS(getSTATUS() | IECBITON);
-        if (disk_status != READY){
-            SYSCALL(VERHO, &(mutex[disk_sem_idx]), 0, 0);
-            return 0 - disk_status;
-        }
-        disk_dev_reg_addr->d_data0 = src;
-        setSTATUS(getSTATUS() & (~IECBITON));
-            disk_dev_reg_addr->d_command = (headNo << HEADNUM_SHIFT) + (sectNo << SECTNUM_SHIFT) + WRITEBLK_DSK; /*write*/
-            disk_status = SYSCALL(IOWAIT, DISKINT, devNo, 0);
-        setSTATUS(getSTATUS() | IECBITON);
-    SYSCALL(VERHO, &(mutex[disk_sem_idx]), 0, 0);
-
-    if (disk_status == READY){
-        return disk_status;
-    } else {
-        return 0 - disk_status;
-    }
-}
+/**********************************************************
+ *  write_fault
+ *
+ *  Handles a TLB-Modification exception. Only shared pages
+ *  are mapped read-only, unmodified image pages and pages
+ *  cloned by FORK: a page with other sharers is copied to a
+ *  private frame, a page with none left is just marked
+ *  dirty. A write to a page evicted or made writable
+ *  meanwhile is simply retried.
+ *
+ *  Parameters:
+ *         support_t *currentSupport – support struct of the faulting U-proc
+ *
+ *  Returns:
+ *
+ **********************************************************/
+HIDDEN void write_fault(support_t *currentSupport) {
+	unsigned int entryHi = currentSupport->sup_exceptState[PGFAULTEXCEPT].s_entryHI;
+	int VPN = (entryHi >> VPN_SHIFT) & VPN_MASK;
+	int frame, newFrame;
+	pte_t *pte;
 
-HIDDEN void read_from_disk_for_pager(int devNo, int sectNo2D, int dst, support_t *currentSupport){
-	int disk_sem_idx = devSemIdx(DISKINT, devNo, FALSE);
+	SYSCALL(PASSERN, &swapPoolSema4, 0, 0);
+	pte = helper_find_pte(currentSupport, VPN);
+	if(pte == NULL) {
+		program_trap_handler(currentSupport, &swapPoolSema4);
+	}
+	frame = ((pte->EntryLo & PFN_MASK) - swapPoolStart) / PAGESIZE;
 
-    device_t *disk_dev_reg_addr = devAddrBase(DISKINT, devNo);
+	if((pte->EntryLo & (VBITON | DBITON)) == VBITON) {
+		if(swapPoolTable[frame].sharers == NULL) {
+			/* the only mapping: the page just becomes private */
+			swapPoolTable[frame].imageSect = NO_SLOT;
+			pte->EntryLo |= DBITON;
+		} else {
+			newFrame = get_free_frame(currentSupport);
+			if((pte->EntryLo & (VBITON | DBITON)) == VBITON && ((pte->EntryLo & PFN_MASK) - swapPoolStart) / PAGESIZE == frame && swapPoolTable[frame].sharers != NULL) {
+				helper_copy_block((int *)(swapPoolStart + (frame * PAGESIZE)), (int *)(swapPoolStart + (newFrame * PAGESIZE)));
+				swapPoolTable[newFrame].ASID = currentSupport->sup_asid;
+				swapPoolTable[newFrame].VPN = VPN;
+				swapPoolTable[newFrame].matchingPgTableEntry = pte;
+				swapPoolTable[newFrame].slotRef = &(helper_find_leaf(currentSupport, VPN)->l_slot[VPN & (PGTBL_LEAF_SIZE - 1)]);
+				unmap_frame(frame, pte);
 
-    int maxcyl = ((disk_dev_reg_addr->d_data1) >> 16) & 0xFFFF;
-    int maxhead = ((disk_dev_reg_addr->d_data1) >> 8) & 0xFF;
-    int maxsect = (disk_dev_reg_addr->d_data1) & 0xFF;
+				setSTATUS(getSTATUS() & (~IECBITON));
+				pte->EntryLo = (swapPoolStart + (newFrame * PAGESIZE)) | VBITON | DBITON;
+				/* the old read-only entry may be cached on any processor */
+				TLBCLR();
+				tlb_shootdown();
+				setSTATUS(getSTATUS() | IECBITON);
+			} else {
+				/* evicted or unshared while the frame was made free: retry */
+				helper_free_frame(newFrame);
+			}
+		}
+	}
 
-    if (sectNo2D > (maxcyl*maxhead*maxsect)){
-        program_trap_handler(currentSupport, NULL);
-    }
+	setSTATUS(getSTATUS() & (~IECBITON));
+	helper_tlb_invalidate(entryHi);
+	setSTATUS(getSTATUS() | IECBITON);
+	SYSCALL(VERHO, &swapPoolSema4, 0, 0);
 
-    SYSCALL(PASSERN, &(mutex[disk_sem_idx]), 0, 0);
-        int sectNo = (sectNo2D % (maxhead * maxsect)) % maxsect;
-		int headNo = (sectNo2D % (maxhead * maxsect)) / maxsect; /*divide and round down*/
-    	int cylNo = sectNo2D / (maxhead*maxsect);
-        setSTATUS(getSTATUS() & (~IECBITON));
-            disk_dev_reg_addr->d_command = (cylNo << CYLNUM_SHIFT) + SEEKCYL;
-            int disk_status = SYSCALL(IOWAIT, DISKINT, devNo, 0);
-        setSTATUS(getSTATUS() | IECBITON);
-        if (disk_status != READY){
-            SYSCALL(VERHO, &(mutex[disk_sem_idx]), 0, 0);
-            return 0 - disk_status;
-        }
-        disk_dev_reg_addr->d_data0 = dst;
-        setSTATUS(getSTATUS() & (~IECBITON));
-            disk_dev_reg_addr->d_command = (headNo << HEADNUM_SHIFT) + (sectNo << SECTNUM_SHIFT) + READBLK_DSK;
-            disk_status = SYSCALL(IOWAIT, DISKINT, devNo, 0);
-        setSTATUS(getSTATUS() | IECBITON);
-    SYSCALL(VERHO, &(mutex[disk_sem_idx]), 0, 0);
-
-    if (disk_status == READY){
-        return disk_status;
-    } else{
-        return 0 - disk_status;
-    }
+	LDST((state_PTR) & (currentSupport->sup_exceptState[PGFAULTEXCEPT]));
 }
 
 
@@ -276,6 +1448,10 @@ HIDDEN void read_from_disk_for_pager(int devNo, int sectNo2D, int dst, support_t
  *
  *  Handles page faults by loading the missing page into memory.
  *  Kicks out a page if memory is full and update page tables and TLB.
+ *  A U-proc suspended by load control is held before the fault is
+ *  served, until it is let back in. Image pages are mapped read-only and shared with the other
+ *  U-procs with the same page, as are the pages cloned by FORK;
+ *  writes to them go to write_fault().
  *
  *  Parameters:
  *
@@ -284,90 +1460,387 @@ HIDDEN void read_from_disk_for_pager(int devNo, int sectNo2D, int dst, support_t
  *
  **********************************************************/
 void TLB_exception_handler() {
+	cpu_t faultStart, faultEnd;
+
 	/* Obtain the pointer to the Current Process’s Support Structure. */
 	support_t *currentSupport = SYSCALL(SUPPORTGET, 0, 0, 0);
 
+	/* a U-proc suspended by load control waits here, before it takes any frame */
+	load_admit(currentSupport);
+	STCK(faultStart);
+
 	/* Determine the cause of the TLB exception. )*/
 	int TLBcause = CauseExcCode(currentSupport->sup_exceptState[PGFAULTEXCEPT].s_cause);
 
-	/* If the Cause is a TLB-Modification exception, treat this exception as a program trap */
+	/* A TLB-Modification exception is a write to a shared read-only page */
 	if(TLBcause == TLB_MOD) {
-		program_trap_handler(currentSupport, NULL);
+		write_fault(currentSupport);
 	}
 
+	/* Count the fault for load control, which counts the frames under the Swap Pool semaphore itself. */
+	load_fault(currentSupport->sup_asid);
+
 	/* Gain mutual exclusion over the Swap Pool table. */
 	SYSCALL(PASSERN, &swapPoolSema4, 0, 0);
 
 	/* Determine the missing page number which is found in the saved exception state’s EntryHi */
 	int missingVPN = (currentSupport->sup_exceptState[PGFAULTEXCEPT].s_entryHI >> VPN_SHIFT) & VPN_MASK;
+	trace_record(TRACE_PGFAULT, currentSupport->sup_asid, missingVPN, TLBcause, 0);
 
-	/* find page table index for later use */
-	int pgTableIndex;
-	if(missingVPN == UPROC_STACK_VPN) {
-		pgTableIndex = PAGE_TABLE_SIZE - 1;
-	} else {
-		pgTableIndex = (missingVPN - STARTVPN);
+	/* find (or build) the second-level page table holding the missing page */
+	pgTblLeaf_t *missingLeaf = alloc_leaf(currentSupport, missingVPN);
+	if(missingLeaf == NULL) {
+		/* outside kuseg, or the U-proc ran out of page tables */
+		program_trap_handler(currentSupport, &swapPoolSema4);
+	}
+	pte_t *missingPte = &(missingLeaf->l_pte[missingVPN & (PGTBL_LEAF_SIZE - 1)]);
+	int *missingSlot = &(missingLeaf->l_slot[missingVPN & (PGTBL_LEAF_SIZE - 1)]);
+
+	/* Wait until page p is no longer on its way out. */
+	while(helper_in_transit(missingSlot)) {
+		swap_wait_transit();
 	}
 
-	/* Pick a frame, i, from the Swap Pool.*/
-	int pickedFrame = page_replace();
+	/* A page a page-out had to leave resident is valid again; an unmodified image page already resident for another U-proc is shared. */
+	if((missingPte->EntryLo & VBITON) == 0 && share_image_frame(currentSupport, missingVPN, missingPte, missingSlot) == FALSE) {
+		/* Pick a frame, i, from the Swap Pool, paging out its contents if occupied.*/
+		int pickedFrame = get_free_frame(currentSupport);
+
+		/* Update the Swap Pool table’s entry i to reflect frame i’s new contents: page p belonging to the Current Process’s ASID,
+		and a pointer to the Current Process’s Page Table entry for page p. */
+		swapPoolTable[pickedFrame].ASID = currentSupport->sup_asid;
+		swapPoolTable[pickedFrame].VPN = missingVPN;
+		swapPoolTable[pickedFrame].matchingPgTableEntry = missingPte;
+		swapPoolTable[pickedFrame].slotRef = missingSlot;
+
+		/* Read the contents of page p from its swap slot into frame i; a page never paged out starts zeroed. */
+		if(*missingSlot == NO_SLOT) {
+			helper_zero_frame((int *)(swapPoolStart + (pickedFrame * PAGESIZE)));
+		} else if(isZswapSlot(*missingSlot)) {
+			/* the page leaves the compressed tier */
+			zswap_decompress((int *)(zswapStart + (*missingSlot & ~ZSWAP_SLOT) * ZSWAP_CHUNK), (int *)(swapPoolStart + (pickedFrame * PAGESIZE)));
+			swap_free(*missingSlot);
+			*missingSlot = NO_SLOT;
+			zswapStats[currentSupport->sup_asid].z_hits++;
+		} else {
+			zswapStats[currentSupport->sup_asid].z_reads++;
+			swapPoolTable[pickedFrame].transit = TRUE;
+			int ioStatus = swap_io(missingSlot, &pickedFrame, 1, TRUE);
+			swapPoolTable[pickedFrame].transit = FALSE;
+			swap_wake_transit();
+			if(ioStatus != READY) {
+				program_trap_handler(currentSupport, &swapPoolSema4);
+			}
+			if(*missingSlot < SWAP_FIRST_SLOT) {
+				/* unmodified image page: read-only, so that it can be shared */
+				swapPoolTable[pickedFrame].imageSect = *missingSlot;
+			}
+		}
 
-	/* Determine if frame i is occupied; examine entry i in the Swap Pool table. */
-	if((swapPoolTable[pickedFrame].ASID != -1)) {
-		/* disable interrupts */
 		setSTATUS(getSTATUS() & (~IECBITON));
-		/* Update process x’s Page Table: mark Page Table entry k as not valid.
-		This entry is easily accessible, since the Swap Pool table’s entry i contains a pointer to this Page Table entry. */
-		pte_t *occupiedPgTable = swapPoolTable[pickedFrame].matchingPgTableEntry;
+		/* Update the Current Process’s Page Table entry for page p to indicate it is now present (V bit) and occupying frame i (PFN field).*/
+		/* Set new PFN */
+		swapPoolTable[pickedFrame].matchingPgTableEntry->EntryLo = (swapPoolStart + (pickedFrame * PAGESIZE));
+		/* Set V bit */
+		swapPoolTable[pickedFrame].matchingPgTableEntry->EntryLo |= VBITON;
+		/* Set D bit, but on image pages */
+		if(swapPoolTable[pickedFrame].imageSect == NO_SLOT) {
+			swapPoolTable[pickedFrame].matchingPgTableEntry->EntryLo |= DBITON;
+		}
 
-		occupiedPgTable->EntryLo = (DBITON & GBITOFF) & VBITOFF;
-		/* Update the TLB, if needed. */
+		/* Update the TLB, here and on the other processors. */
 		TLBCLR();
-		int write_out_pg_tbl;
-		if(swapPoolTable[pickedFrame].VPN == UPROC_STACK_VPN) {
-			write_out_pg_tbl = PAGE_TABLE_SIZE - 1;
+		tlb_shootdown();
+		setSTATUS(getSTATUS() | IECBITON);
+	}
+
+	/* Release mutual exclusion over the Swap Pool table. SYS4 */
+	SYSCALL(VERHO, &swapPoolSema4, 0, 0);
+
+	STCK(faultEnd);
+	hist_record(currentSupport->sup_asid, HIST_PGFAULT, faultEnd - faultStart);
+
+	/* Return control to the Current Process */
+	LDST((state_PTR) & (currentSupport->sup_exceptState[PGFAULTEXCEPT]));
+}
+
+/**********************************************************
+ *  wait_asid_transit
+ *
+ *  Waits until no frame mapped by a U-proc is in transit,
+ *  its page tables being written by the page-out meanwhile.
+ *  Must be called holding the swap pool semaphore.
+ *
+ *  Parameters:
+ *         int asid – ASID of the U-proc
+ *
+ *  Returns:
+ *
+ **********************************************************/
+HIDDEN void wait_asid_transit(int asid) {
+	int i = 0;
+	while(i < swapPoolSize) {
+		if(swapPoolTable[i].transit == TRUE && helper_maps_asid(i, asid)) {
+			swap_wait_transit();
+			i = 0;
 		} else {
-			write_out_pg_tbl = (swapPoolTable[pickedFrame].VPN - STARTVPN);
+			i++;
 		}
-		/* enable interrupts */
-		setSTATUS(getSTATUS() | IECBITON);
-		/* Update process x’s backing store.
-		Treat any error status from the write operation as a program trap.*/
-		if((occupiedPgTable->EntryLo & DBITON) == DBITON) { /* D bit set */
+	}
+}
+
+/**********************************************************
+ *  release_mappings
+ *
+ *  Drops every mapping of a U-proc, leaving unoccupied the
+ *  frames nobody else maps, and gives its page tables and
+ *  swap slots back. Must be called holding the swap pool
+ *  semaphore, with none of its frames in transit.
+ *
+ *  Parameters:
+ *         support_t *currentSupport – support struct of the U-proc
+ *
+ *  Returns:
+ *
+ **********************************************************/
+HIDDEN void release_mappings(support_t *currentSupport) {
+	int i;
+	sharer_t *s, *next;
 
-			/* isRead = 0 since we are writing */
-			/* read_write_flash(pickedFrame, currentSupport, write_out_pg_tbl, FALSE); */
-			write_to_disk_for_pager(RESERVED_DISK_NO, 32*(swapPoolTable[pickedFrame].ASID - 1) + write_out_pg_tbl, SWAP_POOL_START + (pickedFrame * PAGESIZE), currentSupport);
+	for(i = 0; i < swapPoolSize; i++) {
+		for(s = swapPoolTable[i].sharers; s != NULL; s = next) {
+			next = s->s_next;
+			if(s->s_asid == currentSupport->sup_asid) {
+				unmap_frame(i, s->s_pte);
+			}
+		}
+		if(swapPoolTable[i].ASID == currentSupport->sup_asid) {
+			unmap_frame(i, swapPoolTable[i].matchingPgTableEntry);
 		}
 	}
+	free_pgTable(currentSupport);
+}
+
+/**********************************************************
+ *  free_swap_frames
+ *
+ *  Releases the frames, swap slots and page tables of a
+ *  terminating U-proc, once none of its pages is in transit.
+ *  Frames it shares stay with the other sharers. Its ASID
+ *  may be given to a forked U-proc later, so no processor
+ *  may keep a translation of it.
+ *
+ *  Parameters:
+ *         support_t *currentSupport – support struct of the U-proc
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void free_swap_frames(support_t *currentSupport) {
+	SYSCALL(PASSERN, &swapPoolSema4, 0, 0);
+	wait_asid_transit(currentSupport->sup_asid);
+	release_mappings(currentSupport);
+
+	setSTATUS(getSTATUS() & (~IECBITON));
+	TLBCLR();
+	tlb_shootdown();
+	setSTATUS(getSTATUS() | IECBITON);
+	SYSCALL(VERHO, &swapPoolSema4, 0, 0);
+}
 
-	/* Read the contents of the Current Process’s backingstore/flash device logical page p into frame i. */
-	/* isRead = 1 since we are reading */
-	/* read_write_flash(pickedFrame, currentSupport, pgTableIndex, TRUE);*/
-	read_from_disk_for_pager(RESERVED_DISK_NO, 32*(currentSupport->sup_asid - 1) + pgTableIndex, SWAP_POOL_START + (pickedFrame * PAGESIZE), currentSupport);
+/**********************************************************
+ *  clone_pgTable
+ *
+ *  Gives a new U-proc a copy-on-write copy of the address
+ *  space of another one (FORK). The child gets a second-level
+ *  table for every one of the parent, with the same swap
+ *  slots, each one referenced once more. Every resident
+ *  frame of the parent is mapped by the child too, as a
+ *  sharer, and both mappings become read-only: the first
+ *  write by either side takes a TLB-Modification exception
+ *  and write_fault() gives the writer a private copy. Nothing
+ *  is copied or read here.
+ *
+ *  Parameters:
+ *         support_t *parentSupport – support struct of the caller
+ *         support_t *childSupport – support struct of the child,
+ *                                   with its ASID and an empty page table
+ *
+ *  Returns:
+ *         int – TRUE on success; FALSE if page tables or
+ *               sharer entries ran out, the child then maps nothing
+ **********************************************************/
+int clone_pgTable(support_t *parentSupport, support_t *childSupport) {
+	pgTblLeaf_t *leaf, *childLeaf;
+	pte_t *pte;
+	sharer_t *s;
+	int i, j, frame;
+	int done = TRUE;
 
-	/* Update the Swap Pool table’s entry i to reflect frame i’s new contents: page p belonging to the Current Process’s ASID,
-	and a pointer to the Current Process’s Page Table entry for page p. */
-	swapPoolTable[pickedFrame].ASID = currentSupport->sup_asid;
-	swapPoolTable[pickedFrame].VPN = missingVPN;
-	swapPoolTable[pickedFrame].matchingPgTableEntry = &(currentSupport->sup_privatePgTbl[pgTableIndex]);
+	SYSCALL(PASSERN, &swapPoolSema4, 0, 0);
+	/* slots of the parent's pages on their way out are not known yet */
+	wait_asid_transit(parentSupport->sup_asid);
 
 	setSTATUS(getSTATUS() & (~IECBITON));
-	/* Update the Current Process’s Page Table entry for page p to indicate it is now present (V bit) and occupying frame i (PFN field).*/
-	/* Set new PFN */
-	swapPoolTable[pickedFrame].matchingPgTableEntry->EntryLo = (SWAP_POOL_START + (pickedFrame * PAGESIZE));
-	/* Set V bit */
-	swapPoolTable[pickedFrame].matchingPgTableEntry->EntryLo |= VBITON;
-	/* Set D bit */
-	swapPoolTable[pickedFrame].matchingPgTableEntry->EntryLo |= DBITON;
-
-	/* Update the TLB. */
+	for(i = 0; i < PGDIR_SIZE && done == TRUE; i++) {
+		leaf = parentSupport->sup_pgDir[i];
+		if(leaf == NULL) {
+			continue;
+		}
+		childLeaf = alloc_leaf(childSupport, leaf->l_region << LEAF_SHIFT);
+		if(childLeaf == NULL) {
+			done = FALSE;
+			break;
+		}
+		for(j = 0; j < PGTBL_LEAF_SIZE; j++) {
+			childLeaf->l_slot[j] = leaf->l_slot[j];
+			swap_share(leaf->l_slot[j]);
+
+			pte = &(leaf->l_pte[j]);
+			if((pte->EntryLo & VBITON) == VBITON) {
+				if(sharerFree_h == NULL) {
+					done = FALSE;
+					break;
+				}
+				frame = ((pte->EntryLo & PFN_MASK) - swapPoolStart) / PAGESIZE;
+				s = sharerFree_h;
+				sharerFree_h = s->s_next;
+				s->s_asid = childSupport->sup_asid;
+				s->s_vpn = (leaf->l_region << LEAF_SHIFT) + j;
+				s->s_pte = &(childLeaf->l_pte[j]);
+				s->s_slotRef = &(childLeaf->l_slot[j]);
+				s->s_next = swapPoolTable[frame].sharers;
+				swapPoolTable[frame].sharers = s;
+
+				pte->EntryLo &= DBITOFF;
+				childLeaf->l_pte[j].EntryLo = pte->EntryLo;
+			}
+		}
+	}
+	/* the parent's writable translations may be cached on any processor */
 	TLBCLR();
+	tlb_shootdown();
 	setSTATUS(getSTATUS() | IECBITON);
 
-	/* Release mutual exclusion over the Swap Pool table. SYS4 */
+	if(done == FALSE) {
+		release_mappings(childSupport);
+	}
 	SYSCALL(VERHO, &swapPoolSema4, 0, 0);
+	return done;
+}
 
-	/* Return control to the Current Process */
-	LDST((state_PTR) & (currentSupport->sup_exceptState[PGFAULTEXCEPT]));
+/**********************************************************
+ *  pin_page
+ *
+ *  Makes sure the page at the given address of the Current
+ *  Process is resident and private, and pins its frame so
+ *  the pager will not pick it as a victim until
+ *  remap_swap_frame() or unpin_swap_frame() is called.
+ *
+ *  Parameters:
+ *         support_t *currentSupport – support struct of the owner
+ *         unsigned int vAddr – any address inside the page
+ *
+ *  Returns:
+ *         int – index of the pinned swap pool frame
+ **********************************************************/
+int pin_page(support_t *currentSupport, unsigned int vAddr) {
+	int frame;
+	pte_t *pte;
+
+	while(TRUE) {
+		/* touch the page so that the pager brings it in if needed, and unshares it */
+		*((volatile int *)vAddr) = *((volatile int *)vAddr);
+
+		SYSCALL(PASSERN, &swapPoolSema4, 0, 0);
+		pte = helper_find_pte(currentSupport, (vAddr >> VPN_SHIFT) & VPN_MASK);
+		if((pte->EntryLo & (VBITON | DBITON)) == (VBITON | DBITON)) {
+			frame = ((pte->EntryLo & PFN_MASK) - swapPoolStart) / PAGESIZE;
+			swapPoolTable[frame].pinned = TRUE;
+			SYSCALL(VERHO, &swapPoolSema4, 0, 0);
+			return frame;
+		}
+		/* evicted again before we got the swap pool, retry */
+		SYSCALL(VERHO, &swapPoolSema4, 0, 0);
+	}
+}
+
+/**********************************************************
+ *  unpin_swap_frame
+ *
+ *  Releases a frame pinned by pin_page() without moving it.
+ *
+ *  Parameters:
+ *         int frame – swap pool frame index
+ *
+ *  Returns:
+ *
+ **********************************************************/
+void unpin_swap_frame(int frame) {
+	SYSCALL(PASSERN, &swapPoolSema4, 0, 0);
+	swapPoolTable[frame].pinned = FALSE;
+	SYSCALL(VERHO, &swapPoolSema4, 0, 0);
+}
+
+/**********************************************************
+ *  remap_swap_frame
+ *
+ *  Hands a pinned frame over to another U-proc without
+ *  copying it: the owner's page table entry is invalidated,
+ *  the receiver's entry is pointed at the frame, and only
+ *  the two affected TLB entries are dropped. Whatever frame
+ *  the receiver had for that page is released, or kept for
+ *  its other sharers. The frame is private (see pin_page()).
+ *  The previous
+ *  owner sees its backing store copy on its next access.
+ *
+ *  Parameters:
+ *         int frame – pinned swap pool frame index
+ *         support_t *dstSupport – support struct of the receiver
+ *         unsigned int dstVAddr – any address inside the receiver's page
+ *
+ *  Returns:
+ *         int – FALSE if the receiver has no page table left
+ *               for the page (the frame stays pinned), TRUE otherwise
+ **********************************************************/
+int remap_swap_frame(int frame, support_t *dstSupport, unsigned int dstVAddr) {
+	int dstVPN = (dstVAddr >> VPN_SHIFT) & VPN_MASK;
+	pte_t *srcPte;
+
+	SYSCALL(PASSERN, &swapPoolSema4, 0, 0);
+	srcPte = swapPoolTable[frame].matchingPgTableEntry;
+	pgTblLeaf_t *dstLeaf = alloc_leaf(dstSupport, dstVPN);
+	if(dstLeaf == NULL) {
+		SYSCALL(VERHO, &swapPoolSema4, 0, 0);
+		return FALSE;
+	}
+	pte_t *dstPte = &(dstLeaf->l_pte[dstVPN & (PGTBL_LEAF_SIZE - 1)]);
+
+	setSTATUS(getSTATUS() & (~IECBITON));
+
+	/* the receiver's current copy of the page, if resident, is dropped */
+	if((dstPte->EntryLo & VBITON) == VBITON) {
+		int oldFrame = ((dstPte->EntryLo & PFN_MASK) - swapPoolStart) / PAGESIZE;
+		unmap_frame(oldFrame, dstPte);
+		helper_tlb_invalidate(dstPte->EntryHi);
+	}
+
+	/* the sender no longer maps the frame */
+	srcPte->EntryLo = (DBITON & GBITOFF) & VBITOFF;
+	helper_tlb_invalidate(srcPte->EntryHi);
+
+	/* the receiver maps it, dirty so that it reaches the receiver's backing store on eviction */
+	dstPte->EntryLo = (swapPoolStart + (frame * PAGESIZE)) | VBITON | DBITON;
+
+	swapPoolTable[frame].ASID = dstSupport->sup_asid;
+	swapPoolTable[frame].VPN = dstVPN;
+	swapPoolTable[frame].matchingPgTableEntry = dstPte;
+	swapPoolTable[frame].slotRef = &(dstLeaf->l_slot[dstVPN & (PGTBL_LEAF_SIZE - 1)]);
+	swapPoolTable[frame].pinned = FALSE;
+
+	/* the sender or the receiver may have run on another processor */
+	tlb_shootdown();
+	setSTATUS(getSTATUS() | IECBITON);
+	SYSCALL(VERHO, &swapPoolSema4, 0, 0);
+	return TRUE;
 }
@@ -16,11 +16,24 @@
 #include "../h/const.h"
 
 /* global variables */
-extern swapPoolFrame_t swapPoolTable[SWAP_POOL_SIZE];
+extern swapPoolFrame_t *swapPoolTable;
+extern int swapPoolSize;
+extern memaddr swapPoolStart;
 extern int swapPoolSema4;
+extern zswapStat_t zswapStats[MAXUPROC + 1];
 
 void initSwapStruct();
 void uTLB_RefillHandler();
 void TLB_exception_handler();
+pgTblLeaf_t *helper_find_leaf(support_t *currentSupport, int VPN);
+pte_t *helper_find_pte(support_t *currentSupport, int VPN);
+pgTblLeaf_t *alloc_leaf(support_t *currentSupport, int VPN);
+void free_pgTable(support_t *currentSupport);
+void free_swap_frames(support_t *currentSupport);
+int clone_pgTable(support_t *parentSupport, support_t *childSupport);
+void helper_tlb_invalidate(unsigned int entryHi);
+int pin_page(support_t *currentSupport, unsigned int vAddr);
+void unpin_swap_frame(int frame);
+int remap_swap_frame(int frame, support_t *dstSupport, unsigned int dstVAddr);
 
 #endif
\ No newline at end of file
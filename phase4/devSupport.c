@@ -22,7 +22,8 @@ void WRITE_TO_DISK(support_t *currentSupport){
     int maxhead = ((disk_dev_reg_addr->d_data1) >> 8) & 0xFF;
     int maxsect = (disk_dev_reg_addr->d_data1) & 0xFF;
 
-    if ((saved_gen_exc_state->s_a1 < KUSEG) || (saved_gen_exc_state->s_a3 > (maxcyl*maxhead*maxsect))){         /*when setting up backing store as disk, depending on where on disk storing an image, it should be illegal to write there too*/
+    /* the disks of SWAP_DISK_MASK hold the staged images and the swapped pages: not the U-proc's to write */
+    if ((saved_gen_exc_state->s_a1 < KUSEG) || (saved_gen_exc_state->s_a3 > (maxcyl*maxhead*maxsect)) || ((SWAP_DISK_MASK >> devNo) & 1)){
         program_trap_handler(currentSupport, NULL);
     }
 
@@ -30,21 +31,14 @@ void WRITE_TO_DISK(support_t *currentSupport){
         int sectNo = (saved_gen_exc_state->s_a3) % maxsect;
 	    int headNo = ((int) ((saved_gen_exc_state->s_a3) / (maxsect * maxcyl))) % maxhead; /*divide and round down*/
         int cylNo = ((int) ((saved_gen_exc_state->s_a3) / maxsect)) % maxcyl;
-        setSTATUS(getSTATUS() & (~IECBITON));
-            disk_dev_reg_addr->d_command = (cylNo << CYLNUM_SHIFT) + SEEKCYL; /*seek*/
-            int disk_status = SYSCALL(IOWAIT, DISKINT, devNo, 0);
-        setSTATUS(getSTATUS() | IECBITON);
+        int disk_status = SYSCALL(DOIO, doioDev(DISKINT, devNo, FALSE), (cylNo << CYLNUM_SHIFT) + SEEKCYL, 0); /*seek*/
         if (disk_status != READY){
             saved_gen_exc_state->s_v0 = 0 - disk_status;
             SYSCALL(VERHO, &(mutex[disk_sem_idx]), 0, 0);
             return;
         }
-        helper_copy_block(saved_gen_exc_state->s_a1, DISK_DMA_BUFFER_BASE_ADDR + (BLOCKSIZE*devNo));
-        disk_dev_reg_addr->d_data0 = DISK_DMA_BUFFER_BASE_ADDR + (BLOCKSIZE*devNo); /*carefull not to do anything with device between writing to data0 and command*/
-        setSTATUS(getSTATUS() & (~IECBITON));
-            disk_dev_reg_addr->d_command = (headNo << HEADNUM_SHIFT) + (sectNo << SECTNUM_SHIFT) + WRITEBLK_DSK; /*write*/
-            disk_status = SYSCALL(IOWAIT, DISKINT, devNo, 0);
-        setSTATUS(getSTATUS() | IECBITON);
+        helper_copy_block(saved_gen_exc_state->s_a1, diskDmaBuf + (BLOCKSIZE*devNo));
+        disk_status = SYSCALL(DOIO, doioDev(DISKINT, devNo, FALSE), (headNo << HEADNUM_SHIFT) + (sectNo << SECTNUM_SHIFT) + WRITEBLK_DSK, diskDmaBuf + (BLOCKSIZE*devNo)); /*write*/
     SYSCALL(VERHO, &(mutex[disk_sem_idx]), 0, 0);
 
     if (disk_status == READY){
@@ -66,7 +60,8 @@ void READ_FROM_DISK(support_t *currentSupport){
     int maxhead = ((disk_dev_reg_addr->d_data1) >> 8) & 0xFF;
     int maxsect = (disk_dev_reg_addr->d_data1) & 0xFF;
 
-    if ((saved_gen_exc_state->s_a1 < KUSEG) || (saved_gen_exc_state->s_a3 > (maxcyl*maxhead*maxsect))){         /*when setting up backing store as disk, depending on where on disk storing an image, it should be illegal to write there too*/
+    /* the disks of SWAP_DISK_MASK hold the staged images and the swapped pages: not the U-proc's to read */
+    if ((saved_gen_exc_state->s_a1 < KUSEG) || (saved_gen_exc_state->s_a3 > (maxcyl*maxhead*maxsect)) || ((SWAP_DISK_MASK >> devNo) & 1)){
         program_trap_handler(currentSupport, NULL);
     }
 
@@ -74,21 +69,14 @@ void READ_FROM_DISK(support_t *currentSupport){
         int sectNo = saved_gen_exc_state->s_a3 % maxsect;
         int headNo = ((int) (saved_gen_exc_state->s_a3 / (maxsect * maxcyl))) % maxhead;
         int cylNo = ((int) (saved_gen_exc_state->s_a3 / maxsect)) % maxcyl;
-        setSTATUS(getSTATUS() & (~IECBITON));
-            disk_dev_reg_addr->d_command = (cylNo << CYLNUM_SHIFT) + SEEKCYL;
-            int disk_status = SYSCALL(IOWAIT, DISKINT, devNo, 0);
-        setSTATUS(getSTATUS() | IECBITON);
+        int disk_status = SYSCALL(DOIO, doioDev(DISKINT, devNo, FALSE), (cylNo << CYLNUM_SHIFT) + SEEKCYL, 0);
         if (disk_status != READY){
             saved_gen_exc_state->s_v0 = 0 - disk_status;
             SYSCALL(VERHO, &(mutex[disk_sem_idx]), 0, 0);
             return;
         }
-        disk_dev_reg_addr->d_data0 = DISK_DMA_BUFFER_BASE_ADDR + (BLOCKSIZE*devNo);
-        setSTATUS(getSTATUS() & (~IECBITON));
-            disk_dev_reg_addr->d_command = (headNo << HEADNUM_SHIFT) + (sectNo << SECTNUM_SHIFT) + READBLK_DSK;
-            disk_status = SYSCALL(IOWAIT, DISKINT, devNo, 0);
-        setSTATUS(getSTATUS() | IECBITON);
-        helper_copy_block(DISK_DMA_BUFFER_BASE_ADDR + (BLOCKSIZE*devNo), saved_gen_exc_state->s_a1);
+        disk_status = SYSCALL(DOIO, doioDev(DISKINT, devNo, FALSE), (headNo << HEADNUM_SHIFT) + (sectNo << SECTNUM_SHIFT) + READBLK_DSK, diskDmaBuf + (BLOCKSIZE*devNo));
+        helper_copy_block(diskDmaBuf + (BLOCKSIZE*devNo), saved_gen_exc_state->s_a1);
     SYSCALL(VERHO, &(mutex[disk_sem_idx]), 0, 0);
 
     if (disk_status == READY){
@@ -105,17 +93,15 @@ void READ_FROM_FLASH(support_t *currentSupport){
 
     device_t *flash_dev_reg_addr = devAddrBase(FLASHINT, devNo);
 
-    if ((saved_exception_state->s_a1 < KUSEG) || (saved_exception_state->s_a3 < 32) || (saved_exception_state->s_a3 >= flash_dev_reg_addr->d_data1)){ /* should it be illegal to read from backing store area in flash?*/
+    /* the image is below UPROC_IMAGE_PAGES; on the flashes of SWAP_FLASH_MASK the swapped pages are from SWAP_FLASH_FIRST on */
+    if ((saved_exception_state->s_a1 < KUSEG) || (saved_exception_state->s_a3 < UPROC_IMAGE_PAGES) || (saved_exception_state->s_a3 >= flash_dev_reg_addr->d_data1)
+        || (((SWAP_FLASH_MASK >> devNo) & 1) && (saved_exception_state->s_a3 >= SWAP_FLASH_FIRST))){
         program_trap_handler(currentSupport, NULL);
     }
 
     SYSCALL(PASSERN, &(mutex[flash_sem_idx]), 0, 0);
-        flash_dev_reg_addr->d_data0 = FLASK_DMA_BUFFER_BASE_ADDR + BLOCKSIZE*devNo;
-        setSTATUS(getSTATUS() & (~IECBITON));
-            flash_dev_reg_addr->d_command = (saved_exception_state->s_a3 << BLOCKNUM_SHIFT) + READBLK_FLASH;
-            int flash_status = SYSCALL(IOWAIT,FLASHINT, devNo, 0);
-        setSTATUS(getSTATUS() | IECBITON);
-        helper_copy_block(FLASK_DMA_BUFFER_BASE_ADDR + BLOCKSIZE*devNo, saved_exception_state->s_a1);
+        int flash_status = SYSCALL(DOIO, doioDev(FLASHINT, devNo, FALSE), (saved_exception_state->s_a3 << BLOCKNUM_SHIFT) + READBLK_FLASH, flashDmaBuf + BLOCKSIZE*devNo);
+        helper_copy_block(flashDmaBuf + BLOCKSIZE*devNo, saved_exception_state->s_a1);
     SYSCALL(VERHO, &(mutex[flash_sem_idx]), 0, 0);
 
     if (flash_status == READY){
@@ -132,17 +118,15 @@ void WRITE_TO_FLASH(support_t *currentSupport){
     
     device_t *flash_dev_reg_addr = devAddrBase(FLASHINT, devNo);
 
-    if ((saved_exception_state->s_a1 < KUSEG) || (saved_exception_state->s_a3 < 32) || (saved_exception_state->s_a3 >= flash_dev_reg_addr->d_data1)){
+    /* the image is below UPROC_IMAGE_PAGES; on the flashes of SWAP_FLASH_MASK the swapped pages are from SWAP_FLASH_FIRST on */
+    if ((saved_exception_state->s_a1 < KUSEG) || (saved_exception_state->s_a3 < UPROC_IMAGE_PAGES) || (saved_exception_state->s_a3 >= flash_dev_reg_addr->d_data1)
+        || (((SWAP_FLASH_MASK >> devNo) & 1) && (saved_exception_state->s_a3 >= SWAP_FLASH_FIRST))){
         program_trap_handler(currentSupport, NULL);
     }
     
     SYSCALL(PASSERN, &(mutex[flash_sem_idx]), 0, 0);
-        helper_copy_block(saved_exception_state->s_a1, FLASK_DMA_BUFFER_BASE_ADDR + BLOCKSIZE*devNo);
-        flash_dev_reg_addr->d_data0 = FLASK_DMA_BUFFER_BASE_ADDR + BLOCKSIZE*devNo;
-        setSTATUS(getSTATUS() & (~IECBITON));
-            flash_dev_reg_addr->d_command = (saved_exception_state->s_a3 << BLOCKNUM_SHIFT) + WRITEBLK_FLASH;
-            int flash_status = SYSCALL(IOWAIT, FLASHINT, devNo, 0);
-        setSTATUS(getSTATUS() | IECBITON);
+        helper_copy_block(saved_exception_state->s_a1, flashDmaBuf + BLOCKSIZE*devNo);
+        int flash_status = SYSCALL(DOIO, doioDev(FLASHINT, devNo, FALSE), (saved_exception_state->s_a3 << BLOCKNUM_SHIFT) + WRITEBLK_FLASH, flashDmaBuf + BLOCKSIZE*devNo);
     SYSCALL(VERHO, &(mutex[flash_sem_idx]), 0, 0);
 
     if (flash_status == READY){
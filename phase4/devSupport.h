@@ -10,6 +10,8 @@
 
 extern int masterSemaphore;
 extern int mutex[DEVINTNUM * DEVPERINT + DEVPERINT];
+extern memaddr diskDmaBuf;
+extern memaddr flashDmaBuf;
 
 void WRITE_TO_DISK(support_t *currentSupport);
 void READ_FROM_DISK(support_t *currentSupport);
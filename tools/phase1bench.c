@@ -0,0 +1,373 @@
+/*********************************PHASE1BENCH.C*******************************
+ *  Phase 1 benchmark (host tool)
+ *
+ *  Links phase1/pcb.c and phase1/asl.c natively and replays a trace of
+ *  process queue and ASL operations against them, so that two
+ *  implementations can be compared in seconds instead of in the
+ *  emulator. A trace has one operation per line, '#' starting a comment:
+ *
+ *      insertProcQ q p     removeProcQ q     outProcQ q p
+ *      insertBlocked s p   removeBlocked s   outBlocked p
+ *
+ *  with p a pcb (0 to MAXPROC - 1, all allocated up front), q one of
+ *  QUEUES tail pointers and s one of SEMS semaphores. The trace is first
+ *  checked against a model of the queues, and replayed once checking
+ *  every returned pcb. Then it is replayed -r times as a whole, giving
+ *  the mean ns/op, and -r times more timing every operation alone, giving
+ *  the mean and worst case per operation (the clock overhead, measured
+ *  beforehand, is subtracted).
+ *
+ *  "phase1bench -g ops [seed]" writes a random trace with a kernel-like
+ *  mix instead: mostly ready queue traffic, then blocking and unblocking,
+ *  and a few terminations taking a pcb out of the middle of a queue.
+ *
+ *  Usage: phase1bench [-r rounds] trace
+ *         phase1bench -g ops [seed] > trace
+ *
+ *      Written by Phuong and Oghap on Oct 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "phase1shim.h"
+
+#define QUEUES 4
+#define SEMS 64
+
+#define OP_INSERTPROCQ 0
+#define OP_REMOVEPROCQ 1
+#define OP_OUTPROCQ 2
+#define OP_INSERTBLOCKED 3
+#define OP_REMOVEBLOCKED 4
+#define OP_OUTBLOCKED 5
+#define OPKINDS 6
+
+static const char *opNames[OPKINDS] = {
+	"insertProcQ", "removeProcQ", "outProcQ", "insertBlocked", "removeBlocked", "outBlocked"
+};
+
+typedef struct op_t {
+	int kind;
+	int where;  /* queue or semaphore */
+	int pcb;    /* operand, -1 if none */
+	int expect; /* pcb the operation returns, -1 for NULL */
+} op_t;
+
+static op_t *ops;
+static int nops;
+
+static pcb_PTR pcbs[MAXPROC];
+static pcb_PTR queues[QUEUES];
+static int sems[SEMS];
+
+/* model of the queues: FIFO of pcb numbers per queue and per semaphore */
+#define PLACES (QUEUES + SEMS)
+static int fifo[PLACES][MAXPROC];
+static int fifoLen[PLACES];
+static int placeOf[MAXPROC]; /* -1 if in no queue */
+
+static void model_reset(void) {
+	int i;
+	for(i = 0; i < PLACES; i++) {
+		fifoLen[i] = 0;
+	}
+	for(i = 0; i < MAXPROC; i++) {
+		placeOf[i] = -1;
+	}
+}
+
+static void model_push(int place, int p) {
+	fifo[place][fifoLen[place]++] = p;
+	placeOf[p] = place;
+}
+
+static int model_out(int place, int p) {
+	int i;
+	for(i = 0; i < fifoLen[place] && fifo[place][i] != p; i++) {
+		;
+	}
+	if(i == fifoLen[place]) {
+		return -1;
+	}
+	memmove(&fifo[place][i], &fifo[place][i + 1], (fifoLen[place] - i - 1) * sizeof(int));
+	fifoLen[place]--;
+	placeOf[p] = -1;
+	return p;
+}
+
+/* applies op to the model, filling in the expected result; -1 if the op is invalid */
+static int model_apply(op_t *op) {
+	int place = op->where;
+
+	if(op->kind >= OP_INSERTBLOCKED) {
+		place += QUEUES;
+	}
+	switch(op->kind) {
+		case OP_INSERTPROCQ:
+		case OP_INSERTBLOCKED:
+			if(placeOf[op->pcb] != -1) {
+				return -1; /* a pcb sits in one queue at a time */
+			}
+			model_push(place, op->pcb);
+			op->expect = -1;
+			return 0;
+		case OP_REMOVEPROCQ:
+		case OP_REMOVEBLOCKED:
+			op->expect = fifoLen[place] > 0 ? model_out(place, fifo[place][0]) : -1;
+			return 0;
+		case OP_OUTPROCQ:
+			op->expect = model_out(place, op->pcb);
+			return 0;
+		case OP_OUTBLOCKED:
+			if(placeOf[op->pcb] >= 0 && placeOf[op->pcb] < QUEUES) {
+				return -1; /* the Nucleus never does it: outBlocked trusts p_state */
+			}
+			if(placeOf[op->pcb] == -1) {
+				op->expect = -1;
+				return 0;
+			}
+			op->expect = model_out(placeOf[op->pcb], op->pcb);
+			return 0;
+	}
+	return -1;
+}
+
+/* fresh modules with every pcb allocated and every queue empty */
+static void reset(void) {
+	int i;
+	initPcbs();
+	initASL();
+	for(i = 0; i < MAXPROC; i++) {
+		pcbs[i] = allocPcb();
+	}
+	for(i = 0; i < QUEUES; i++) {
+		queues[i] = mkEmptyProcQ();
+	}
+}
+
+static pcb_PTR run(const op_t *op) {
+	switch(op->kind) {
+		case OP_INSERTPROCQ:
+			insertProcQ(&queues[op->where], pcbs[op->pcb]);
+			return UMPS_NULL;
+		case OP_REMOVEPROCQ:
+			return removeProcQ(&queues[op->where]);
+		case OP_OUTPROCQ:
+			return outProcQ(&queues[op->where], pcbs[op->pcb]);
+		case OP_INSERTBLOCKED:
+			insertBlocked(&sems[op->where], pcbs[op->pcb]);
+			return UMPS_NULL;
+		case OP_REMOVEBLOCKED:
+			return removeBlocked(&sems[op->where]);
+		default:
+			return outBlocked(pcbs[op->pcb]);
+	}
+}
+
+static long long now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void load(const char *path) {
+	FILE *f = fopen(path, "r");
+	char line[128], name[32];
+	int a, b, n, cap = 1024, lineNo = 0;
+	op_t op;
+
+	if(f == NULL) {
+		perror(path);
+		exit(1);
+	}
+	ops = malloc(cap * sizeof(op_t));
+	model_reset();
+	while(fgets(line, sizeof(line), f) != NULL) {
+		lineNo++;
+		if(line[0] == '#' || (n = sscanf(line, "%31s %d %d", name, &a, &b)) <= 0) {
+			continue;
+		}
+		for(op.kind = 0; op.kind < OPKINDS && strcmp(opNames[op.kind], name) != 0; op.kind++) {
+			;
+		}
+		op.where = 0;
+		op.pcb = -1;
+		switch(op.kind) {
+			case OP_INSERTPROCQ:
+			case OP_OUTPROCQ:
+			case OP_INSERTBLOCKED:
+				op.where = a;
+				op.pcb = b;
+				n -= 3;
+				break;
+			case OP_REMOVEPROCQ:
+			case OP_REMOVEBLOCKED:
+				op.where = a;
+				n -= 2;
+				break;
+			case OP_OUTBLOCKED:
+				op.pcb = a;
+				n -= 2;
+				break;
+		}
+		if(op.kind == OPKINDS || n != 0 || op.where < 0 || op.where >= (op.kind < OP_INSERTBLOCKED ? QUEUES : SEMS) ||
+		   op.pcb < -1 || op.pcb >= MAXPROC || model_apply(&op) != 0) {
+			fprintf(stderr, "%s:%d: bad operation: %s", path, lineNo, line);
+			exit(1);
+		}
+		if(nops == cap) {
+			cap *= 2;
+			ops = realloc(ops, cap * sizeof(op_t));
+		}
+		ops[nops++] = op;
+	}
+	fclose(f);
+}
+
+static void generate(int count, unsigned int seed) {
+	op_t op;
+	int i, r, tries;
+
+	srand(seed);
+	model_reset();
+	printf("# phase1bench -g %d %u\n", count, seed);
+	for(i = 0; i < count; i++) {
+		for(tries = 0;; tries++) {
+			r = rand() % 100;
+			op.pcb = rand() % MAXPROC;
+			if(r < 40) {
+				op.kind = OP_INSERTPROCQ;
+				op.where = rand() % QUEUES;
+			} else if(r < 75) {
+				op.kind = OP_REMOVEPROCQ;
+				op.where = rand() % QUEUES;
+			} else if(r < 85) {
+				op.kind = OP_INSERTBLOCKED;
+				op.where = rand() % SEMS;
+			} else if(r < 95) {
+				op.kind = OP_REMOVEBLOCKED;
+				op.where = rand() % SEMS;
+			} else if(r < 98) {
+				op.kind = OP_OUTPROCQ;
+				op.where = placeOf[op.pcb] >= 0 && placeOf[op.pcb] < QUEUES ? placeOf[op.pcb] : 0;
+			} else {
+				op.kind = OP_OUTBLOCKED;
+			}
+			/* no removals from empty queues, unless nothing else fits */
+			if((op.kind == OP_REMOVEPROCQ && fifoLen[op.where] == 0) ||
+			   (op.kind == OP_REMOVEBLOCKED && fifoLen[QUEUES + op.where] == 0) ||
+			   ((op.kind == OP_OUTPROCQ || op.kind == OP_OUTBLOCKED) && placeOf[op.pcb] == -1)) {
+				if(tries < 100) {
+					continue;
+				}
+			}
+			if(model_apply(&op) == 0) {
+				break;
+			}
+		}
+		switch(op.kind) {
+			case OP_INSERTPROCQ:
+			case OP_OUTPROCQ:
+			case OP_INSERTBLOCKED:
+				printf("%s %d %d\n", opNames[op.kind], op.where, op.pcb);
+				break;
+			case OP_REMOVEPROCQ:
+			case OP_REMOVEBLOCKED:
+				printf("%s %d\n", opNames[op.kind], op.where);
+				break;
+			default:
+				printf("%s %d\n", opNames[op.kind], op.pcb);
+		}
+	}
+}
+
+int main(int argc, char **argv) {
+	int rounds = 100;
+	int i, j, k;
+	long long t0, t1, total, overhead, d;
+	long long kindTime[OPKINDS], kindWorst[OPKINDS];
+	long kindCount[OPKINDS];
+	pcb_PTR got;
+
+	if(argc >= 3 && strcmp(argv[1], "-g") == 0) {
+		generate(atoi(argv[2]), argc >= 4 ? (unsigned int)strtoul(argv[3], NULL, 10) : 1);
+		return 0;
+	}
+	if(argc == 4 && strcmp(argv[1], "-r") == 0) {
+		rounds = atoi(argv[2]);
+		argv += 2;
+	} else if(argc != 2) {
+		fprintf(stderr, "usage: phase1bench [-r rounds] trace\n       phase1bench -g ops [seed] > trace\n");
+		return 2;
+	}
+	load(argv[1]);
+	if(nops == 0 || rounds < 1) {
+		fprintf(stderr, "%s: nothing to replay\n", argv[1]);
+		return 1;
+	}
+
+	/* check round */
+	reset();
+	for(i = 0; i < nops; i++) {
+		got = run(&ops[i]);
+		if((ops[i].expect == -1 && got != UMPS_NULL) || (ops[i].expect != -1 && got != pcbs[ops[i].expect])) {
+			fprintf(stderr, "operation %d (%s): wrong pcb returned\n", i + 1, opNames[ops[i].kind]);
+			return 1;
+		}
+	}
+
+	/* whole replays */
+	total = 0;
+	for(j = 0; j < rounds; j++) {
+		reset();
+		t0 = now_ns();
+		for(i = 0; i < nops; i++) {
+			run(&ops[i]);
+		}
+		total += now_ns() - t0;
+	}
+
+	/* one operation at a time */
+	overhead = -1;
+	for(i = 0; i < 1000; i++) {
+		t0 = now_ns();
+		t1 = now_ns();
+		if(overhead < 0 || t1 - t0 < overhead) {
+			overhead = t1 - t0;
+		}
+	}
+	for(k = 0; k < OPKINDS; k++) {
+		kindTime[k] = kindWorst[k] = 0;
+		kindCount[k] = 0;
+	}
+	for(j = 0; j < rounds; j++) {
+		reset();
+		for(i = 0; i < nops; i++) {
+			t0 = now_ns();
+			run(&ops[i]);
+			d = now_ns() - t0 - overhead;
+			if(d < 0) {
+				d = 0;
+			}
+			k = ops[i].kind;
+			kindTime[k] += d;
+			kindCount[k]++;
+			if(d > kindWorst[k]) {
+				kindWorst[k] = d;
+			}
+		}
+	}
+
+	printf("%d ops x %d rounds: %.1f ns/op\n", nops, rounds, (double)total / ((double)nops * rounds));
+	printf("%-14s %10s %10s %10s\n", "operation", "count", "ns/op", "worst ns");
+	for(k = 0; k < OPKINDS; k++) {
+		if(kindCount[k] > 0) {
+			printf("%-14s %10ld %10.1f %10lld\n", opNames[k], kindCount[k] / rounds,
+			       (double)kindTime[k] / kindCount[k], kindWorst[k]);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,36 @@
+/************************* PHASE1SHIM.H *****************************
+ *
+ *  Host side view of the phase1 modules for tools/phase1bench.
+ *
+ *  h/const.h cannot be included next to the C library (it redefines
+ *  NULL), so the pcb and semaphore descriptors are opaque here and the
+ *  interface of h/pcb.h and h/asl.h is declared again. pcb.c and asl.c
+ *  call nothing from libumps, so they link as they are.
+ *
+ *  Written by Phuong and Oghap on Oct 2026
+ */
+
+#ifndef PHASE1SHIM_H
+#define PHASE1SHIM_H
+
+/* as in h/const.h */
+#define MAXPROC 20
+#define UMPS_NULL ((void *)0xFFFFFFFF) /* the kernel's NULL, returned by the phase1 modules */
+
+typedef struct pcb_t *pcb_PTR;
+
+/* h/pcb.h */
+extern pcb_PTR allocPcb();
+extern void initPcbs();
+extern pcb_PTR mkEmptyProcQ();
+extern void insertProcQ(pcb_PTR *tp, pcb_PTR p);
+extern pcb_PTR removeProcQ(pcb_PTR *tp);
+extern pcb_PTR outProcQ(pcb_PTR *tp, pcb_PTR p);
+
+/* h/asl.h */
+extern int insertBlocked(int *semAdd, pcb_PTR p);
+extern pcb_PTR removeBlocked(int *semAdd);
+extern pcb_PTR outBlocked(pcb_PTR p);
+extern void initASL();
+
+#endif
@@ -0,0 +1,220 @@
+/*********************************PROFSYM.C*******************************
+ *  Profile symbolizer (host tool)
+ *
+ *  Reads the output of PROFILE (PROF_DUMP), as found in printN.umps, maps
+ *  every bucket to the function containing its first address, using the
+ *  symbol tables of the ELF files the images were made from, and prints
+ *  a flat profile per ASID, most sampled function first. ASID 0 holds the
+ *  kernel mode samples and is looked up in the kernel ELF; the others are
+ *  looked up in the U-proc ELF given for them.
+ *
+ *  A bucket covers 64 bytes of code, so a bucket straddling two functions
+ *  is charged entirely to the first one.
+ *
+ *  Usage: profsym [-k kernel] [-u asid=file.t]... [printN.umps]
+ *
+ *      Written by Phuong and Oghap on Oct 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAXUPROC 8 /* as in h/const.h, which cannot be included on the host */
+
+#define SHT_SYMTAB 2
+#define STT_FUNC 2
+#define SHN_UNDEF 0
+
+typedef struct sym_t {
+	unsigned long addr;
+	const char *name;
+	unsigned long count; /* samples */
+} sym_t;
+
+typedef struct image_t {
+	sym_t *syms;         /* functions, by address */
+	int nsyms;
+	unsigned long unknown;  /* samples outside every function */
+	unsigned long outside;  /* samples past the histogram */
+	unsigned long total;
+	int seen;               /* the dump had this ASID */
+} image_t;
+
+static image_t images[MAXUPROC + 1];
+
+/* ELF32 little endian fields (uMPS3 is little endian MIPS) */
+static unsigned long get16(const unsigned char *p) {
+	return p[0] | (p[1] << 8);
+}
+
+static unsigned long get32(const unsigned char *p) {
+	return p[0] | (p[1] << 8) | ((unsigned long)p[2] << 16) | ((unsigned long)p[3] << 24);
+}
+
+static int by_addr(const void *a, const void *b) {
+	const sym_t *x = a, *y = b;
+	return x->addr < y->addr ? -1 : x->addr > y->addr;
+}
+
+static int by_count(const void *a, const void *b) {
+	const sym_t *x = a, *y = b;
+	return x->count > y->count ? -1 : x->count < y->count;
+}
+
+/* loads the function symbols of an ELF32 file */
+static int load_elf(image_t *img, const char *path) {
+	FILE *f = fopen(path, "rb");
+	unsigned char *buf;
+	long size;
+	unsigned long shoff, shentsize, shnum, i, j;
+
+	if(f == NULL) {
+		perror(path);
+		return -1;
+	}
+	fseek(f, 0, SEEK_END);
+	size = ftell(f);
+	rewind(f);
+	buf = malloc(size);
+	if(buf == NULL || fread(buf, 1, size, f) != (size_t)size) {
+		fprintf(stderr, "%s: cannot read\n", path);
+		fclose(f);
+		return -1;
+	}
+	fclose(f);
+
+	if(size < 52 || memcmp(buf, "\177ELF", 4) != 0 || buf[4] != 1 || buf[5] != 1) {
+		fprintf(stderr, "%s: not a 32 bit little endian ELF file\n", path);
+		return -1;
+	}
+	shoff = get32(buf + 32);
+	shentsize = get16(buf + 46);
+	shnum = get16(buf + 48);
+
+	for(i = 0; i < shnum; i++) {
+		const unsigned char *sh = buf + shoff + i * shentsize;
+		const unsigned char *strsh;
+		unsigned long symoff, symsize, symentsize, stroff;
+
+		if(get32(sh + 4) != SHT_SYMTAB) {
+			continue;
+		}
+		symoff = get32(sh + 16);
+		symsize = get32(sh + 20);
+		symentsize = get32(sh + 36);
+		strsh = buf + shoff + get32(sh + 24) * shentsize;
+		stroff = get32(strsh + 16);
+
+		img->syms = malloc((symsize / symentsize) * sizeof(sym_t));
+		for(j = 0; j < symsize / symentsize; j++) {
+			const unsigned char *st = buf + symoff + j * symentsize;
+			if((st[12] & 0xF) != STT_FUNC || get16(st + 14) == SHN_UNDEF) {
+				continue;
+			}
+			img->syms[img->nsyms].addr = get32(st + 4);
+			img->syms[img->nsyms].name = (const char *)buf + stroff + get32(st);
+			img->syms[img->nsyms].count = 0;
+			img->nsyms++;
+		}
+		qsort(img->syms, img->nsyms, sizeof(sym_t), by_addr);
+		return 0;
+	}
+	fprintf(stderr, "%s: no symbol table\n", path);
+	return -1;
+}
+
+/* function containing addr, NULL if none */
+static sym_t *lookup(image_t *img, unsigned long addr) {
+	int lo = 0, hi = img->nsyms - 1, mid;
+	sym_t *found = NULL;
+	while(lo <= hi) {
+		mid = (lo + hi) / 2;
+		if(img->syms[mid].addr <= addr) {
+			found = &img->syms[mid];
+			lo = mid + 1;
+		} else {
+			hi = mid - 1;
+		}
+	}
+	return found;
+}
+
+static void usage(void) {
+	fprintf(stderr, "usage: profsym [-k kernel] [-u asid=file.t]... [printN.umps]\n");
+	exit(2);
+}
+
+int main(int argc, char **argv) {
+	FILE *in = stdin;
+	char line[256];
+	unsigned long asid, pc, count;
+	int i;
+
+	for(i = 1; i < argc; i++) {
+		if(strcmp(argv[i], "-k") == 0 && i + 1 < argc) {
+			if(load_elf(&images[0], argv[++i]) != 0) {
+				return 1;
+			}
+		} else if(strcmp(argv[i], "-u") == 0 && i + 1 < argc) {
+			char *eq = strchr(argv[++i], '=');
+			asid = strtoul(argv[i], NULL, 10);
+			if(eq == NULL || asid == 0 || asid > MAXUPROC) {
+				usage();
+			}
+			if(load_elf(&images[asid], eq + 1) != 0) {
+				return 1;
+			}
+		} else if(argv[i][0] == '-' || in != stdin) {
+			usage();
+		} else if((in = fopen(argv[i], "r")) == NULL) {
+			perror(argv[i]);
+			return 1;
+		}
+	}
+
+	while(fgets(line, sizeof(line), in) != NULL) {
+		if(sscanf(line, "# asid %lu outside %lu", &asid, &count) == 2 && asid <= MAXUPROC) {
+			images[asid].seen = 1;
+			images[asid].outside += count;
+			images[asid].total += count;
+		} else if(sscanf(line, "%lu %lu %lu", &asid, &pc, &count) == 3 && asid <= MAXUPROC) {
+			sym_t *s = lookup(&images[asid], pc);
+			images[asid].seen = 1;
+			images[asid].total += count;
+			if(s != NULL) {
+				s->count += count;
+			} else {
+				images[asid].unknown += count;
+			}
+		}
+		/* other lines are output of the U-proc */
+	}
+
+	for(asid = 0; asid <= MAXUPROC; asid++) {
+		image_t *img = &images[asid];
+		if(!img->seen) {
+			continue;
+		}
+		if(asid == 0) {
+			printf("kernel mode: %lu samples\n", img->total);
+		} else {
+			printf("asid %lu: %lu samples\n", asid, img->total);
+		}
+		if(img->nsyms > 0) {
+			qsort(img->syms, img->nsyms, sizeof(sym_t), by_count);
+		}
+		printf("  %%time  samples  function\n");
+		for(i = 0; i < img->nsyms && img->syms[i].count > 0; i++) {
+			printf("  %5.1f  %7lu  %s\n", 100.0 * img->syms[i].count / img->total, img->syms[i].count, img->syms[i].name);
+		}
+		if(img->unknown > 0) {
+			printf("  %5.1f  %7lu  (no symbol)\n", 100.0 * img->unknown / img->total, img->unknown);
+		}
+		if(img->outside > 0) {
+			printf("  %5.1f  %7lu  (past the histogram)\n", 100.0 * img->outside / img->total, img->outside);
+		}
+		printf("\n");
+	}
+	return 0;
+}
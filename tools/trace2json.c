@@ -0,0 +1,190 @@
+/*********************************TRACE2JSON.C*******************************
+ *  Event trace converter (host tool)
+ *
+ *  Reads the output of TRACEDUMP, as found in printN.umps, and writes a
+ *  Chrome trace (JSON Object Format) that chrome://tracing and Perfetto
+ *  open:
+ *  - process "CPUs": one thread per processor, a slice per dispatch
+ *    (until the next dispatch or idle on that processor), and instant
+ *    events for syscalls, interrupts, page faults and page outs;
+ *  - process "Devices": one thread per (sub)device, a slice from each
+ *    DOIO command to its interrupt.
+ *
+ *  Usage: trace2json [printN.umps] > trace.json
+ *
+ *      Written by Phuong and Oghap on Oct 2026
+ */
+
+#include <stdio.h>
+
+/* as in h/const.h, which cannot be included on the host */
+#define TRACE_SWITCH 0
+#define TRACE_SYSCALL 1
+#define TRACE_INTERRUPT 2
+#define TRACE_PGFAULT 3
+#define TRACE_EVICT 4
+#define TRACE_IOSTART 5
+#define TRACE_IODONE 6
+#define DEVPERINT 8
+
+#define MAXCPU 16
+#define DEVICES 48 /* device semaphores: 5 lines of 8 devices, terminals twice */
+
+/* field order of a dump line */
+typedef struct event_t {
+	unsigned long seq, tod, cpu, kind, asid, arg[3];
+} event_t;
+
+static FILE *out;
+static int first = 1;          /* no event written yet */
+static int started = 0;        /* tod0 is set */
+static unsigned long tod0;     /* TOD of the first event, time 0 of the trace */
+
+static int running[MAXCPU];    /* a dispatch slice is open */
+static event_t lastSwitch[MAXCPU];
+static int ioPending[DEVICES]; /* a command is outstanding */
+static event_t lastIo[DEVICES];
+
+static const char *devClass[] = {"disk", "flash", "net", "printer", "term tx", "term rx"};
+
+/* separator before every event but the first */
+static void sep(void) {
+	fprintf(out, first ? "\n" : ",\n");
+	first = 0;
+}
+
+static unsigned long ts(unsigned long tod) {
+	return (tod - tod0) & 0xFFFFFFFFUL;
+}
+
+static void slice_name(char *buf, size_t len, const event_t *e) {
+	if(e->asid != 0) {
+		snprintf(buf, len, "ASID %lu", e->asid);
+	} else {
+		snprintf(buf, len, "pcb 0x%08lx", e->arg[0]);
+	}
+}
+
+static void close_slice(unsigned long cpu, unsigned long tod) {
+	char name[32];
+	const event_t *s = &lastSwitch[cpu];
+	if(!running[cpu]) {
+		return;
+	}
+	slice_name(name, sizeof name, s);
+	sep();
+	fprintf(out, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%lu,\"ts\":%lu,\"dur\":%lu,"
+	             "\"args\":{\"slice\":%lu}}",
+	        name, cpu, ts(s->tod), (tod - s->tod) & 0xFFFFFFFFUL, s->arg[1]);
+	running[cpu] = 0;
+}
+
+static void instant(const event_t *e, const char *name) {
+	sep();
+	fprintf(out, "{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":0,\"tid\":%lu,\"ts\":%lu,"
+	             "\"args\":{\"asid\":%lu,\"arg0\":%lu,\"arg1\":%lu,\"arg2\":%lu}}",
+	        name, e->cpu, ts(e->tod), e->asid, e->arg[0], e->arg[1], e->arg[2]);
+}
+
+static void event(const event_t *e) {
+	char name[32];
+	unsigned long dev = e->arg[0];
+
+	if(!started) {
+		tod0 = e->tod;
+		started = 1;
+	}
+	if(e->cpu >= MAXCPU) {
+		return;
+	}
+
+	switch(e->kind) {
+		case TRACE_SWITCH:
+			close_slice(e->cpu, e->tod);
+			if(e->arg[0] != 0) {
+				lastSwitch[e->cpu] = *e;
+				running[e->cpu] = 1;
+			}
+			break;
+		case TRACE_SYSCALL:
+			snprintf(name, sizeof name, "SYS%lu", e->arg[0]);
+			instant(e, name);
+			break;
+		case TRACE_INTERRUPT:
+			instant(e, "interrupt");
+			break;
+		case TRACE_PGFAULT:
+			instant(e, "page fault");
+			break;
+		case TRACE_EVICT:
+			instant(e, "page out");
+			break;
+		case TRACE_IOSTART:
+			if(dev < DEVICES) {
+				lastIo[dev] = *e;
+				ioPending[dev] = 1;
+			}
+			break;
+		case TRACE_IODONE:
+			if(dev < DEVICES && ioPending[dev]) {
+				sep();
+				fprintf(out, "{\"name\":\"%s %lu\",\"ph\":\"X\",\"pid\":1,\"tid\":%lu,\"ts\":%lu,\"dur\":%lu,"
+				             "\"args\":{\"asid\":%lu,\"command\":%lu,\"data0\":%lu,\"status\":%lu}}",
+				        devClass[dev / DEVPERINT], dev % DEVPERINT, dev, ts(lastIo[dev].tod),
+				        (e->tod - lastIo[dev].tod) & 0xFFFFFFFFUL, lastIo[dev].asid,
+				        lastIo[dev].arg[1], lastIo[dev].arg[2], e->arg[1]);
+				ioPending[dev] = 0;
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+static void metadata(void) {
+	unsigned long i;
+	sep();
+	fprintf(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"CPUs\"}}");
+	sep();
+	fprintf(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"Devices\"}}");
+	for(i = 0; i < DEVICES; i++) {
+		sep();
+		fprintf(out, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%lu,\"args\":{\"name\":\"%s %lu\"}}",
+		        i, devClass[i / DEVPERINT], i % DEVPERINT);
+	}
+}
+
+int main(int argc, char **argv) {
+	FILE *in = stdin;
+	char line[256];
+	event_t e;
+	unsigned long lastTod = 0;
+	unsigned long cpu;
+
+	if(argc > 1 && (in = fopen(argv[1], "r")) == NULL) {
+		perror(argv[1]);
+		return 1;
+	}
+	out = stdout;
+
+	fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+	while(fgets(line, sizeof line, in) != NULL) {
+		/* the '#' header, and anything else printed on the same printer */
+		if(sscanf(line, "%lu %lu %lu %lu %lu %lu %lu %lu", &e.seq, &e.tod, &e.cpu, &e.kind, &e.asid,
+		          &e.arg[0], &e.arg[1], &e.arg[2]) != 8) {
+			continue;
+		}
+		event(&e);
+		lastTod = e.tod;
+	}
+	for(cpu = 0; cpu < MAXCPU; cpu++) {
+		close_slice(cpu, lastTod);
+	}
+	metadata();
+	fprintf(out, "\n]}\n");
+
+	if(in != stdin) {
+		fclose(in);
+	}
+	return 0;
+}
@@ -0,0 +1,112 @@
+/*********************************WKLDCFG.C*******************************
+ *  Workload parameter writer (host tool)
+ *
+ *  Writes the parameter block of phase3/testers/workload.c into block
+ *  WL_BLOCK of a flash device file made by umps3-mkdev -f. The file is a
+ *  short header followed by 4 KB blocks, so block b starts at
+ *  (size % 4096) + b * 4096. Parameters not given keep the defaults of
+ *  the workload.
+ *
+ *  Usage: wkldcfg flash.umps [burst=us] [ws=pages]
+ *                 [pattern=seq|random|strided|hotcold] [stride=pages]
+ *                 [hot=percent] [touches=n] [io=none|disk|term|printer]
+ *                 [ioevery=ops] [duration=ms]
+ *
+ *      Written by Phuong and Oghap on Oct 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BLOCKSIZE 4096
+
+/* as in phase3/testers/workload.c */
+#define WL_MAGIC 0x444C4B57
+#define WL_BLOCK 32
+#define WL_WORDS 10
+
+static const char *keys[WL_WORDS] = {
+	"", "burst", "ws", "pattern", "stride", "hot", "touches", "io", "ioevery", "duration"
+};
+static const char *patterns[] = {"seq", "random", "strided", "hotcold", NULL};
+static const char *ioDevs[] = {"none", "disk", "term", "printer", NULL};
+
+static long param[WL_WORDS] = {WL_MAGIC, 200, 48, 1, 1, 90, 4, 0, 10, 2000};
+
+static int lookup_name(const char **names, const char *value) {
+	int i;
+	for(i = 0; names[i] != NULL; i++) {
+		if(strcmp(names[i], value) == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+static void usage(void) {
+	fprintf(stderr, "usage: wkldcfg flash.umps [burst=us] [ws=pages] [pattern=seq|random|strided|hotcold]\n"
+	                "               [stride=pages] [hot=percent] [touches=n] [io=none|disk|term|printer]\n"
+	                "               [ioevery=ops] [duration=ms]\n");
+	exit(2);
+}
+
+int main(int argc, char **argv) {
+	unsigned char block[WL_WORDS * 4];
+	FILE *f;
+	long size;
+	int i, k;
+
+	if(argc < 2) {
+		usage();
+	}
+	for(i = 2; i < argc; i++) {
+		char *eq = strchr(argv[i], '=');
+		if(eq == NULL) {
+			usage();
+		}
+		*eq = '\0';
+		for(k = 1; k < WL_WORDS && strcmp(keys[k], argv[i]) != 0; k++) {
+			;
+		}
+		if(k == WL_WORDS) {
+			usage();
+		}
+		if(strcmp(argv[i], "pattern") == 0) {
+			param[k] = lookup_name(patterns, eq + 1);
+		} else if(strcmp(argv[i], "io") == 0) {
+			param[k] = lookup_name(ioDevs, eq + 1);
+		} else {
+			param[k] = strtol(eq + 1, NULL, 10);
+		}
+		if(param[k] < 0) {
+			usage();
+		}
+	}
+
+	f = fopen(argv[1], "r+b");
+	if(f == NULL) {
+		perror(argv[1]);
+		return 1;
+	}
+	fseek(f, 0, SEEK_END);
+	size = ftell(f);
+	if(size < (size % BLOCKSIZE) + (WL_BLOCK + 1) * BLOCKSIZE) {
+		fprintf(stderr, "%s: no block %d, make the flash device larger\n", argv[1], WL_BLOCK);
+		return 1;
+	}
+
+	/* uMPS3 is little endian */
+	for(i = 0; i < WL_WORDS; i++) {
+		block[4 * i] = param[i] & 0xFF;
+		block[4 * i + 1] = (param[i] >> 8) & 0xFF;
+		block[4 * i + 2] = (param[i] >> 16) & 0xFF;
+		block[4 * i + 3] = (param[i] >> 24) & 0xFF;
+	}
+	fseek(f, (size % BLOCKSIZE) + (long)WL_BLOCK * BLOCKSIZE, SEEK_SET);
+	if(fwrite(block, 1, sizeof(block), f) != sizeof(block) || fclose(f) != 0) {
+		perror(argv[1]);
+		return 1;
+	}
+	return 0;
+}